@@ -0,0 +1 @@
+../src/sat/aigSat.h
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <cassert>
 #include <iostream>
 #include <iomanip>
+#include <thread>
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "cirCmd.h"
@@ -17,7 +18,21 @@
 using namespace std;
 
 extern CirMgr* cirMgr;
-extern int effLimit;
+
+// "-Threads" beyond the cores of the machine only costs memory (one proof
+// model or pattern block per thread); cut the request down to them
+static int
+clampThreads(int threads)
+{
+   int cores = thread::hardware_concurrency();
+   if (cores <= 0) cores = MAX_THREADS;
+   if (threads > cores) {
+      cerr << "Note: -Threads " << threads << " is reduced to " << cores
+           << "..." << endl;
+      threads = cores;
+   }
+   return threads;
+}
 
 bool
 initCirCmd()
@@ -30,6 +45,7 @@ initCirCmd()
          cmdMgr->regCmd("CIRSTRash", 6, new CirStrashCmd) &&
          cmdMgr->regCmd("CIRSIMulate", 6, new CirSimCmd) &&
          cmdMgr->regCmd("CIRFraig", 4, new CirFraigCmd) &&
+         cmdMgr->regCmd("CIRCEC", 6, new CirCECCmd) &&
          cmdMgr->regCmd("CIRWrite", 4, new CirWriteCmd)
       )) {
       cerr << "Registering \"cir\" commands fails... exiting" << endl;
@@ -184,7 +200,7 @@ CirGateCmd::exec(const string& option)
 
    int gateId = -1, level = 0;
    bool doFanin = false, doFanout = false;
-   CirGate* thisGate = 0;
+   bool hasGate = false;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       bool checkLevel = false;
       if (myStrNCmp("-FANIn", options[i], 5) == 0) {
@@ -199,16 +215,16 @@ CirGateCmd::exec(const string& option)
          doFanout = true;
          checkLevel = true;
       }
-      else if (!thisGate) {
+      else if (!hasGate) {
          if (!myStr2Int(options[i], gateId) || gateId < 0)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
-         thisGate = cirMgr->getGate(gateId);
-         if (!thisGate) {
+         if (!cirMgr->isGate(gateId)) {
             cerr << "Error: Gate(" << gateId << ") not found!!" << endl;
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[0]);
          }
+         hasGate = true;
       }
-      else if (thisGate)
+      else if (hasGate)
          return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
       else
          return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
@@ -221,17 +237,17 @@ CirGateCmd::exec(const string& option)
       }
    }
 
-   if (!thisGate) {
+   if (!hasGate) {
       cerr << "Error: Gate id is not specified!!" << endl;
       return CmdExec::errorOption(CMD_OPT_MISSING, options.back());
    }
 
    if (doFanin)
-      thisGate->reportFanin(level);
+      cirMgr->reportFanin(gateId, level);
    else if (doFanout)
-      thisGate->reportFanout(level);
+      cirMgr->reportFanout(gateId, level);
    else
-      thisGate->reportGate();
+      cirMgr->reportGate(gateId);
 
    return CMD_EXEC_DONE;
 }
@@ -354,7 +370,8 @@ CirStrashCmd::exec(const string& option)
            << endl;
       return CMD_EXEC_ERROR;
    }
-   cirMgr->strash();
+   // readCircuit() builds a strashed netlist and every later pass keeps it
+   // so; the command is kept for old dofiles and only records its state
    curCmd = CIRSTRASH;
 
    return CMD_EXEC_DONE;
@@ -375,7 +392,8 @@ CirStrashCmd::help() const
 
 //----------------------------------------------------------------------
 //    CIRSIMulate <-Random | -File <string patternFile>>
-//                [-Output (string logFile)]
+//                [-Output (string logFile)] [-Width (int bits)]
+//                [-Threads (int numThreads)] [-Seed (int seed)]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirSimCmd::exec(const string& option)
@@ -391,6 +409,7 @@ CirSimCmd::exec(const string& option)
    ifstream patternFile;
    ofstream logFile;
    bool doRandom = false, doFile = false, doLog = false;
+   int width = 0, threads = 0, seed = -1;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       if (myStrNCmp("-Random", options[i], 2) == 0) {
          if (doRandom || doFile)
@@ -417,20 +436,54 @@ CirSimCmd::exec(const string& option)
             return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
          doLog = true;
       }
+      else if (myStrNCmp("-Width", options[i], 2) == 0) {
+         if (width)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], width) || width <= 0 || width % 64)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
+      else if (myStrNCmp("-Threads", options[i], 2) == 0) {
+         if (threads || doFile)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], threads) || threads <= 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
+      else if (myStrNCmp("-Seed", options[i], 2) == 0) {
+         if (seed >= 0 || doFile)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], seed) || seed < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
       else
          return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
    }
 
    if (!doRandom && !doFile)
       return CmdExec::errorOption(CMD_OPT_MISSING, "");
+   if (threads && !doRandom)
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, "-Threads");
+   if (seed >= 0 && !doRandom)
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, "-Seed");
 
    assert (curCmd != CIRINIT);
    if (doLog)
       cirMgr->setSimLog(&logFile);
    else cirMgr->setSimLog(0);
+   if (width)
+      cirMgr->setSimWidth(width);
+   if (seed >= 0) {
+      patGen.setSeed(seed);
+      cirMgr->setSimSeed(seed);
+   }
 
    if (doRandom)
-      cirMgr->randomSim();
+      cirMgr->randomSim(threads? clampThreads(threads) : 1);
    else
       cirMgr->fileSim(patternFile);
    cirMgr->setSimLog(0);
@@ -443,7 +496,9 @@ void
 CirSimCmd::usage(ostream& os) const
 {
    os << "Usage: CIRSIMulate <-Random | -File <string patternFile>>\n"
-      << "                   [-Output (string logFile)]" << endl;
+      << "                   [-Output (string logFile)] [-Width (int bits)]\n"
+      << "                   [-Threads (int numThreads)] [-Seed (int seed)]"
+      << endl;
 }
 
 void
@@ -454,7 +509,8 @@ CirSimCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRFraig
+//    CIRFraig [-ConflictLimit (int conflicts)] [-TimeLimit (int seconds)]
+//             [-Threads (int numThreads)] [-Engine <cnf | circuit>]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirFraigCmd::exec(const string& option)
@@ -467,14 +523,52 @@ CirFraigCmd::exec(const string& option)
    vector<string> options;
    CmdExec::lexOptions(option, options);
 
-   if (!options.empty())
-      return CmdExec::errorOption(CMD_OPT_EXTRA, options[0]);
+   int conflictLimit = -1, timeLimit = -1, threads = 0, engine = -1;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-ConflictLimit", options[i], 2) == 0) {
+         if (conflictLimit >= 0)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], conflictLimit) || conflictLimit < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
+      else if (myStrNCmp("-TimeLimit", options[i], 3) == 0) {
+         if (timeLimit >= 0)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], timeLimit) || timeLimit < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
+      else if (myStrNCmp("-Threads", options[i], 3) == 0) {
+         if (threads)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], threads) || threads <= 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
+      else if (myStrNCmp("-Engine", options[i], 2) == 0) {
+         if (engine >= 0)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (myStrNCmp("cnf", options[i], 2) == 0) engine = 0;
+         else if (myStrNCmp("circuit", options[i], 2) == 0) engine = 1;
+         else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
+      else
+         return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+   }
 
    if (curCmd != CIRSIMULATE) {
       cerr << "Error: circuit is not yet simulated!!" << endl;
       return CMD_EXEC_ERROR;
    }
-   cirMgr->fraig();
+   cirMgr->fraig(conflictLimit >= 0? conflictLimit : FRAIG_CONFLICTS,
+                 timeLimit >= 0? timeLimit : 0, threads? clampThreads(threads) : 1,
+                 engine == 1);
    curCmd = CIRFRAIG;
 
    return CMD_EXEC_DONE;
@@ -483,7 +577,10 @@ CirFraigCmd::exec(const string& option)
 void
 CirFraigCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRFraig" << endl;
+   os << "Usage: CIRFraig [-ConflictLimit (int conflicts)] "
+      << "[-TimeLimit (int seconds)]\n"
+      << "                [-Threads (int numThreads)] [-Engine <cnf | circuit>]"
+      << endl;
 }
 
 void
@@ -494,7 +591,40 @@ CirFraigCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRWrite [(int gateId)][-Output (string aagFile)]
+//    CIRCEC <(string file1)> <(string file2)>
+//----------------------------------------------------------------------
+CmdExecStatus
+CirCECCmd::exec(const string& option)
+{
+   // check option
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options, 2))
+      return CMD_EXEC_ERROR;
+
+   // The miter is a circuit of its own; the one read by CIRRead is kept
+   CirMgr miter;
+   if (!miter.readMiter(options[0], options[1]))
+      return CMD_EXEC_ERROR;
+   miter.cec();
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirCECCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRCEC <(string file1)> <(string file2)>" << endl;
+}
+
+void
+CirCECCmd::help() const
+{
+   cout << setw(15) << left << "CIRCEC: "
+        << "check the equivalence of two circuits PO by PO\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRWrite [(int gateId)][-Output (string aagFile)] [-Binary]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirWriteCmd::exec(const string& option)
@@ -511,30 +641,33 @@ CirWriteCmd::exec(const string& option)
       cirMgr->writeAag(cout);
       return CMD_EXEC_DONE;
    }
-   bool hasFile = false;
-   int gateId;
-   CirGate *thisGate = NULL;
-   ofstream outfile;
+   bool hasFile = false, doBinary = false;
+   int gateId = -1;
+   bool hasGate = false;
+   string fileName;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       if (myStrNCmp("-Output", options[i], 2) == 0) {
          if (hasFile) 
             return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
          if (++i == n)
             return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
-         outfile.open(options[i].c_str(), ios::out);
-         if (!outfile)
-            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[1]);
+         fileName = options[i];
          hasFile = true;
       }
+      else if (myStrNCmp("-Binary", options[i], 2) == 0) {
+         if (doBinary)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doBinary = true;
+      }
       else if (myStr2Int(options[i], gateId) && gateId >= 0) {
-         if (thisGate != NULL)
+         if (hasGate)
             return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
-         thisGate = cirMgr->getGate(gateId);
-         if (!thisGate) {
+         if (!cirMgr->isGate(gateId)) {
             cerr << "Error: Gate(" << gateId << ") not found!!" << endl;
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          }
-         if (!thisGate->isAig()) {
+         hasGate = true;
+         if (!cirMgr->isAig(gateId)) {
              cerr << "Error: Gate(" << gateId << ") is NOT an AIG!!" << endl;
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          }
@@ -542,12 +675,32 @@ CirWriteCmd::exec(const string& option)
       else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
    }
 
-   if (!thisGate) {
-      assert (hasFile);
-      cirMgr->writeAag(outfile);
+   if (doBinary) {
+      if (hasGate) {
+         cerr << "Error: -Binary writes the whole netlist only!!" << endl;
+         return CMD_EXEC_ERROR;
+      }
+      if (!hasFile) {
+         cerr << "Error: binary AIG cannot be written to the screen!!" << endl;
+         return CMD_EXEC_ERROR;
+      }
+   }
+
+   ofstream outfile;
+   if (hasFile) {
+      outfile.open(fileName.c_str(), doBinary? ios::out | ios::binary: ios::out);
+      if (!outfile)
+         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, fileName);
    }
-   else if (hasFile) cirMgr->writeGate(outfile, thisGate);
-   else cirMgr->writeGate(cout, thisGate);
+
+   if (doBinary)
+      cirMgr->writeAig(outfile);
+   else if (!hasGate) {
+      if (hasFile) cirMgr->writeAag(outfile);
+      else cirMgr->writeAag(cout);
+   }
+   else if (hasFile) cirMgr->writeGate(outfile, gateId);
+   else cirMgr->writeGate(cout, gateId);
 
    return CMD_EXEC_DONE;
 }
@@ -555,13 +708,14 @@ CirWriteCmd::exec(const string& option)
 void
 CirWriteCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRWrite [(int gateId)][-Output (string aagFile)]" << endl;
+   os << "Usage: CIRWrite [(int gateId)][-Output (string aagFile)] [-Binary]"
+      << endl;
 }
 
 void
 CirWriteCmd::help() const
 {
    cout << setw(15) << left << "CIRWrite: "
-        << "write the netlist to an ASCII AIG file (.aag)\n";
+        << "write the netlist to an ASCII (.aag) or binary (.aig) AIG file\n";
 }
 
@@ -19,6 +19,7 @@ CmdClass(CirOptCmd);
 CmdClass(CirStrashCmd);
 CmdClass(CirSimCmd);
 CmdClass(CirFraigCmd);
+CmdClass(CirCECCmd);
 CmdClass(CirWriteCmd);
 
 #endif // CIR_CMD_H
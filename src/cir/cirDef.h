@@ -15,8 +15,30 @@
 using namespace std;
 
 // TODO: define your own typedef or enum
+enum GateType
+{
+   UNDEF_GATE = 0,
+   PI_GATE    = 1,
+   PO_GATE    = 2,
+   AIG_GATE   = 3,
+   CONST_GATE = 4,
 
-class CirGate;
+   TOT_GATE,
+   NO_GATE = TOT_GATE // an id that is not in use
+};
+
+// Default signature length in 64-bit words (256 patterns per pass)
+#define SIM_WORDS 4
+
+// Default conflicts per fraig SAT query; pairs left undecided are retried
+// with four times the budget, at most FRAIG_RETRIES times
+#define FRAIG_CONFLICTS 1000
+#define FRAIG_RETRIES   4
+
+// Bound of "-Threads" when the number of cores cannot be found out
+#define MAX_THREADS 64
+
+class CirGateStore;
 class CirMgr;
 class SatSolver;
 
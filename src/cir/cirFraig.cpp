@@ -9,6 +9,8 @@
 #include <cassert>
 #include <algorithm>
 #include <ctime>
+#include <thread>
+#include <functional>
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "sat.h"
@@ -17,7 +19,7 @@
 
 using namespace std;
 
-// TODO: Please keep "CirMgr::strash()" and "CirMgr::fraig()" for cir cmd.
+// TODO: Please keep "CirMgr::fraig()" for cir cmd.
 //       Feel free to define your own variables or functions
 
 /*******************************/
@@ -27,98 +29,85 @@ using namespace std;
 /**************************************/
 /*   Static varaibles and functions   */
 /**************************************/
-class CirKey
-{
-public:
-	//CirKey() { cerr << "You should not use default constructor, idiot!" << endl; }
-	CirKey(AigGateV ptr1,AigGateV ptr2): g1(ptr1), g2(ptr2) {}
-
-	size_t operator() () const { return (g1 & g2); }
-
-	bool operator == (const CirKey& k) const { return (((g1 == k.g1) && (g2 == k.g2)) || ((g1 == k.g2) && (g2 == k.g1))); }
-
-private:
-	AigGateV g1,g2;
-};
-
 
 /*******************************************/
 /*   Public member functions about fraig   */
 /*******************************************/
-// _floatList may be changed.
-// _unusedList and _undefList won't be changed
-void
-CirMgr::strash()
-{
-	HashMap<CirKey,CirGate*> cirHash(_size/2);
-	updateDfsList();
-	vector<size_t> mergedList;
-	for(unsigned i = 0; i < _dfsList.size(); ++i){
-		if(_dfsList[i] -> getTypeStr() != "AIG") continue;
-		//cout << "checking "; _dfsList[i] -> printGate();  cout << endl;
-		AigGateV& g1 = (_dfsList[i] -> getFanInList())[0];
-		AigGateV& g2 = (_dfsList[i] -> getFanInList())[1];
-		CirKey k(g1,g2);
-		CirGate* ptr = 0;
-		if(cirHash.query(k,ptr)){
-			size_t gid = _dfsList[i] -> getGateID();
-			cout << "Strashing: " << ptr -> getGateID() << " merging " << gid << endl;
-			mergedList.push_back(_dfsList[i] -> getGateID());
-			ptr -> merge(_dfsList[i]);
-			_dfsList[i] = 0;
-			_gateList[gid] = 0;
-			--_AIGsize;
-		}
-		else
-			cirHash.insert(k,_dfsList[i]);
-	}
-}
-
+// Each SAT query may spend "conflictLimit" conflicts (0: no limit); pairs
+// it leaves undecided are retried in later rounds with a larger budget.
+// After "timeLimit" seconds (0: no limit) the remaining pairs are skipped.
+// With "threads" > 1 the pairs of a round are proved in parallel.  With
+// "circuit" the queries go to the circuit SAT engine instead of the CNF one.
 void
-CirMgr::fraig()
+CirMgr::fraig(unsigned conflictLimit, unsigned timeLimit, unsigned threads, bool circuit)
 {
 	unsigned count = 0; //indicate the proofs SAT engine has proved.
 	unsigned unsatNum = 0; //indicate the number of UNSAT (that should be merged) SAT engine has made.
-	clock_t start,stop;
-	bool _do = true;
-	vector<pair<CirGate*,unsigned>> mergeList;
-	vector<CirGate*> undefList;
+	bool timeout = false;
+	vector<pair<unsigned,unsigned>> mergeList;
 	updateDfsList();
-	SatSolver* s = new SatSolver;
-	s -> initialize();
-	genProofModel(s);
-	vector<CirGate*> _netList = _dfsList;
-	for(unsigned i = 0; i < _dfsList.size(); ++i){
-		if(_dfsList[i] -> getTypeStr() == "UNDEF")
-			undefList.push_back(_dfsList[i]);
-	}
+	IdList _netList = _dfsList;
 
 	if(_fecGrps.empty()) { return; }
 
-	start = clock();
-
-	if(_gateList[0] -> getFec() != -1)
-		proveFEC(s,_gateList[0],mergeList);
-
-	stop = clock();
-	if((double)(stop-start)/CLOCKS_PER_SEC > 120) _do = false;
+	// SAT models of disproved pairs are resimulated to split other false
+	// FEC candidates before they reach the solver
+	buildSimOrder();
+	setSimBlocks(1);
+	_cexPattern.assign(_PIsize*_simWords,0);
+	_cexNum = 0;
+
+	const time_t start = time(0);
+	int64 budget = conflictLimit? (int64)conflictLimit : -1;
+	unsigned retries = 0, undecided = 0;
+	// one proof model per thread
+	vector<ProofModel> pm(threads);
+	for(unsigned t = 0; t < threads; ++t){
+		pm[t].circuit = circuit;
+		genProofModel(pm[t]);
+		pm[t].setBudget(budget);
+	}
 
-	if(_do){
-		for(unsigned i = 0; i < _netList.size(); ++i){
-			if(_netList[i] -> getTypeStr() != "AIG") continue;
-			if(_netList[i] -> getFec() == -1) continue;
-			proveFEC(s,_netList[i],mergeList);
-			stop = clock();
-			//if(abs((double)(stop-start)/CLOCKS_PER_SEC) < 2) break;
-			if((double)(stop-start)/CLOCKS_PER_SEC > 150) break;
+	// Sweep in rounds: every candidate is proved against its group's
+	// representative once per round; the counterexamples of the round then
+	// split the disproved candidates off, and the next round retries them
+	// against their new representatives.  A hard pair only costs its budget
+	// per round, which grows while pairs are left undecided.
+	while(true){
+		unsigned disproved = 0;
+		undecided = 0;
+		if(threads > 1)
+			timeout = proveRound(pm,_netList,mergeList,disproved,undecided,start,timeLimit);
+		else{
+			for(unsigned i = 0; i < _netList.size(); ++i){
+				if(!_gates.isAig(_netList[i])) continue;
+				if(_fecId[_netList[i]] == -1) continue;
+				int result = proveFEC(pm[0],_netList[i],mergeList);
+				if(result == 1) ++disproved;
+				else if(result == -1) ++undecided;
+				if(_cexNum >= 64) simCex();
+				if(timeLimit && difftime(time(0),start) >= timeLimit) { timeout = true; break; }
+			}
+		}
+		if(timeout) break;
+		if(_cexNum) simCex();
+		if(undecided && retries < FRAIG_RETRIES){
+			++retries;
+			budget *= 4;
+			for(unsigned t = 0; t < threads; ++t)
+				pm[t].setBudget(budget);
 		}
+		else if(!disproved) break;
 	}
-
 	merge(mergeList);
+	if(timeout)
+		cout << "Fraig: time limit reached; remaining FEC pairs are skipped" << endl;
+	else if(undecided)
+		cout << "Fraig: " << undecided << " FEC pair(s) left undecided" << endl;
 	resetFecGrps();
 	for(unsigned i = 0; i <= _size; ++i){
-		if(!_gateList[i]) continue;
-		_gateList[i] -> setFecId(0);
+		if(!_gates.exists(i)) continue;
+		if(i == 0 || _gates.isAig(i)) _fecId[i] = 0;
 	}
 	_fecInit = false;
 /*
@@ -135,138 +124,421 @@ CirMgr::fraig()
 
 	for(unsigned i = 0; i < _fecGrps.size(); ++i){
 		for(unsigned j = 0; j < _fecGrps[i] -> size(); ++j){
-			_gateList[(*_fecGrps[i])[j]] -> setFecId(i);
+			_fecId[(*_fecGrps[i])[j]] = i;
 		}
 	}
 */
 	updateDfsList();
 
-	for(unsigned i = 0; i < _POsize; ++i){
-		dynamic_cast<POGate*>(_gateList[_POList[i]]) -> updateInfo();
-	}
-
 	_AIGsize = 0;
 
 	for(unsigned i = 0; i <= _size; ++i){
-		if(!_gateList[i]) continue;
-		if(_gateList[i] -> getTypeStr() == "AIG")
+		if(!_gates.exists(i)) continue;
+		if(_gates.isAig(i))
 			++_AIGsize;
 	}
+}
 
-	strash();
-
-	delete s;
-	
+// Check a circuit built by readMiter() PO by PO: simulate and fraig the
+// (already strashed) miter quietly, then prove each pair of POs the sweep
+// has not joined.
+// A counterexample lists the PI values in the order of a pattern file.
+void
+CirMgr::cec()
+{
+	const unsigned poNum = _POsize/2;
+	_quiet = true;
+	randomSim();
+	fraig();
+	_quiet = false;
+
+	ProofModel m;
+	genProofModel(m);
+	unsigned diff = 0;
+	for(unsigned i = 0; i < poNum; ++i){
+		const unsigned lit1 = _gates.getFanIn(_POList[i],0);
+		const unsigned lit2 = _gates.getFanIn(_POList[poNum + i],0);
+		unsigned id1 = lit1/2, id2 = lit2/2;
+		bool isInv = ((lit1 ^ lit2) & 1);
+		int result = (id1 == id2 && !isInv)? 0: provePair(m,id1,id2,isInv);
+		cout << "PO " << i;
+		if(getName(_POList[i]) != "") cout << " (" << getName(_POList[i]) << ")";
+		if(!result){
+			cout << ": equivalent" << endl;
+			continue;
+		}
+		++diff;
+		getModel(m,_cexModel);
+		cout << ": NOT equivalent, counterexample ";
+		for(unsigned j = 0; j < _PIsize; ++j)
+			cout << ((_cexModel[j/64] >> (j%64)) & 1);
+		cout << endl;
+	}
+	if(diff)
+		cout << "The circuits are NOT equivalent (" << diff << " of " << poNum << " POs differ)." << endl;
+	else
+		cout << "The circuits are equivalent." << endl;
 }
 
 /********************************************/
 /*   Private member functions about fraig   */
 /********************************************/
+// Only the constant is encoded up front; loadCone() adds the clauses of a
+// gate's transitive fanin when a proof first needs it.  A gate is in the
+// solver iff its satVar is nonzero (Var 0 is reserved by SatSolver).
 void
-CirMgr::genProofModel(SatSolver*& s)
+CirMgr::genProofModel(ProofModel& m) const
 {
-	updateDfsList();
-	Var vc = s -> newVar();
-	(_gateList[0]) -> setVar(vc);
-	for(unsigned i = 0; i < _dfsList.size(); ++i){
-		if(_dfsList[i] -> getTypeStr() == "AIG"){
-			Var v = s -> newVar();
-			(_dfsList[i]) -> setVar(v);
-		}
-		if(_dfsList[i] -> getTypeStr() == "PI"){
-			Var v = s -> newVar();
-			(_dfsList[i]) -> setVar(v);
-		}
-		if(_dfsList[i] -> getTypeStr() == "UNDEF"){
-			Var v = s -> newVar();
-			(_dfsList[i]) -> setVar(v);
-			s -> assumeProperty(_dfsList[i] -> getVar(),false);
-		}
+	m.satVar.assign(_size + 1,0);
+	if(m.circuit){
+		m.aigSolver.initialize();
+		m.satVar[0] = m.aigSolver.newVar();
+	}
+	else{
+		m.solver.initialize();
+		m.satVar[0] = m.solver.newVar();
 	}
+	m.retired = 0;
+}
+
+void
+CirMgr::loadCone(ProofModel& m,unsigned g) const
+{
+	if(m.circuit) loadCone(m,m.aigSolver,g);
+	else loadCone(m,m.solver,g);
+}
 
-	for(unsigned i = 0; i < _dfsList.size(); ++i){
-		if(_dfsList[i] -> getTypeStr() != "AIG") continue;
-		AigGateV& p1 = (_dfsList[i] -> getFanInList())[0];
-		AigGateV& p2 = (_dfsList[i] -> getFanInList())[1];
-		s -> addAigCNF((_dfsList[i]) -> getVar(),p1.gate() -> getVar(),p1.isInv(),p2.gate() -> getVar(),p2.isInv());
+template<class S> void
+CirMgr::loadCone(ProofModel& m,S& s,unsigned g) const
+{
+	if(m.satVar[g]) return;
+	vector<pair<unsigned,unsigned>>& stack = m.stack;
+	stack.clear();
+	stack.push_back(make_pair(g,0u));
+	while(!stack.empty()){
+		unsigned cur = stack.back().first;
+		if(_gates.isAig(cur) && stack.back().second < 2){
+			unsigned in = _gates.getFanInId(cur,stack.back().second++);
+			if(!m.satVar[in])
+				stack.push_back(make_pair(in,0u));
+			continue;
+		}
+		stack.pop_back();
+		if(m.satVar[cur]) continue;
+		// PIs and undefined gates are free variables
+		m.satVar[cur] = s.newVar();
+		// decide along the first simulated pattern: it satisfies the
+		// cone, so a SAT answer needs only the decisions the miter forces
+		if(!_simValue.empty()) s.seedPolarity(m.satVar[cur],getSimValue(cur));
+		if(!_gates.isAig(cur)) continue;
+		const unsigned lit0 = _gates.getFanIn(cur,0), lit1 = _gates.getFanIn(cur,1);
+		s.addAigCNF(m.satVar[cur],m.satVar[lit0/2],lit0 % 2,m.satVar[lit1/2],lit1 % 2);
 	}
-	s -> assumeProperty((_gateList[0]) -> getVar(),false);
 }
 
+// Return the representative (first live member) of the FEC group of "id"
 unsigned
-CirMgr::proveFEC(SatSolver*& s,CirGate*& g,vector<pair<CirGate*,unsigned>>& p) //return the # of gates that should be merge
+CirMgr::fecRep(unsigned id)
 {
-	IdList*& list = (_fecGrps[g -> getFec()]);
-	unsigned id = g -> getGateID();
-	unsigned oldSize = list -> size();
-
-	vector<int> tmpList;
-	for(unsigned i = 0; i < list -> size(); ++i)
-		tmpList.push_back((*list)[i]);
-
-	if(tmpList.size() == 1){ _gateList[tmpList[0]] -> setFecId(-1); tmpList[0] = -1; list -> clear(); return 0; }
-
-	for(unsigned i = 0; i < tmpList.size(); ++i){
-		if(tmpList[i] == id) { tmpList[i] = -1; continue; }
-		if(tmpList[i] == -1) continue;
-		bool isInv = false;
-		bool result;
-		if(g -> getPattern() == ~(_gateList[tmpList[i]]) -> getPattern()) isInv = true;
-		Var newVar = s -> newVar();
-		s -> addXorCNF(newVar,g -> getVar(),false,_gateList[tmpList[i]] -> getVar(),isInv);
-		s -> assumeRelease();
-		s -> assumeProperty(newVar,true);
-		s -> assumeProperty(_gateList[0] -> getVar(),false);
-		/*for(unsigned i = 0; i < undefList.size() ++i){
-			s -> assumeProperty(undefList[i] -> getVar(),false);
-		}
-		*/
-		cout << "Proving (" << id << ",";
-		if(isInv) cout << "!";
-		cout << tmpList[i] << ")..." << flush;
+	int grp = _fecId[id];
+	unsigned& first = _fecGrps[grp].first;
+	while(_fecId[_fecMember[first]] != grp) ++first;
+	return _fecMember[first];
+}
+
+// Ask the solver of "m" whether gates "repId" and "id" (inverted if
+// "isInv") differ; return 1/0/-1 for SAT/UNSAT/undecided.  Only "m" is
+// written, so threads with their own proof models may call this at once.
+int
+CirMgr::provePair(ProofModel& m,unsigned repId,unsigned id,bool isInv) const
+{
+	if(m.circuit) return provePair(m,m.aigSolver,repId,id,isInv);
+	return provePair(m,m.solver,repId,id,isInv);
+}
+
+template<class S> int
+CirMgr::provePair(ProofModel& m,S& s,unsigned repId,unsigned id,bool isInv) const
+{
+	// Retired activation variables cannot be deleted; once they are
+	// half of the solver, start over.  Proven merges reach the netlist,
+	// so the reloaded cones lose little.
+	if(2*m.retired > s.getNumVars()) genProofModel(m);
+	loadCone(m,s,repId);
+	loadCone(m,s,id);
+	// The miter is switched on by an activation variable and retired
+	// right after the query, so its clauses are dropped as satisfied
+	Var act = s.newVar();
+	s.addMiterCNF(act,m.satVar[repId],m.satVar[id],isInv);
+	s.assumeRelease();
+	s.assumeProperty(act,true);
+	s.assumeProperty(m.satVar[0],false);
+	int result = s.assumpSolveLimited();
+	s.assertProperty(act,false);
+	++m.retired;
+	// keep the proven equivalence for the following queries
+	if(result == 0) s.addEqCNF(m.satVar[repId],m.satVar[id],isInv);
+	return result;
+}
+
+// Prove "id" against the representative of its FEC group.  On UNSAT "id" is
+// merged into the representative right away, so later cones see the
+// simplified netlist; fanouts that become structurally equal are merged
+// too.  Return 1 if the pair was disproved (SAT), with the
+// model recorded for resimulation, -1 if the solver ran out of budget,
+// and 0 otherwise
+int
+CirMgr::proveFEC(ProofModel& m,unsigned id,vector<pair<unsigned,unsigned>>& p)
+{
+	unsigned repId = fecRep(id);
+	if(repId == id) return 0;
+
+	bool isInv = false;
+	if(getSimValue(repId) == ~getSimValue(id)) isInv = true;
+	cout << "Proving (" << repId << ",";
+	if(isInv) cout << "!";
+	cout << id << ")..." << flush;
+	cout << char(13) << setw(30) << ' ' << char(13);
+	int result = provePair(m,repId,id,isInv);
+
+	cout << "(" << repId << ",";
+	if(isInv) cout << "!";
+	cout << id << ")" << " ";
+
+	if(result == -1){
+		cout << "UNDECIDED" << flush;
+		cout << char(13) << setw(30) << ' ' << char(13);
+		return -1;
+	}
+	if(result == 1){
+		cout << "SAT" << flush;
 		cout << char(13) << setw(30) << ' ' << char(13);
-		result = s -> assumpSolve();
+		getModel(m,_cexModel);
+		addCex(_cexModel);
+		_cexPair.push_back(pair<unsigned,unsigned>(id,repId));
+		return 1;
+	}
+	cout << "UNSAT" << flush;
+	cout << char(13) << setw(30) << ' ' << char(13);
+	vector<unsigned> outs;
+	unhash(id);
+	unhashFanOut(id,outs);
+	_gates.fraigMerge(repId,id,isInv);
+	p.push_back(pair<unsigned,unsigned>(repId,2*id+isInv));
+	_fecId[id] = -1;
+	rehash(outs);
+	return 0;
+}
 
-		cout << "(" << id << ",";
-		if(isInv) cout << "!";
-		cout << tmpList[i] << ")" << " ";
+// Prove every candidate of "netList" against its representative on all
+// proof models in parallel.  The netlist stays read-only meanwhile: each
+// FEC group goes to one thread, the groups are balanced by size, and the
+// results are applied afterwards in topological order, so the outcome
+// does not depend on timing.  Return true if the time limit was hit.
+bool
+CirMgr::proveRound(vector<ProofModel>& pm,const vector<unsigned>& netList,vector<pair<unsigned,unsigned>>& p,unsigned& disproved,unsigned& undecided,time_t start,unsigned timeLimit)
+{
+	const unsigned threads = pm.size();
+	vector<FraigTask> tasks;
+	vector<unsigned> grpSize(_fecGrps.size(),0);
+	for(unsigned i = 0; i < netList.size(); ++i){
+		unsigned id = netList[i];
+		if(!_gates.isAig(id)) continue;
+		if(_fecId[id] == -1) continue;
+		unsigned repId = fecRep(id);
+		if(repId == id) continue;
+		FraigTask t;
+		t.rep = repId;
+		t.id = id;
+		t.grp = _fecId[id];
+		t.inv = (getSimValue(repId) == ~getSimValue(id));
+		t.result = -2;
+		tasks.push_back(t);
+		++grpSize[t.grp];
+	}
 
-		if(result){
-			cout << "SAT" << flush;
-			cout << char(13) << setw(30) << ' ' << char(13);
+	// largest groups first, each to the least loaded thread
+	vector<pair<unsigned,unsigned>> order; // (~size, group)
+	for(unsigned i = 0; i < grpSize.size(); ++i)
+		if(grpSize[i]) order.push_back(pair<unsigned,unsigned>(~grpSize[i],i));
+	sort(order.begin(),order.end());
+	vector<unsigned> owner(_fecGrps.size(),0), load(threads,0);
+	for(unsigned i = 0; i < order.size(); ++i){
+		unsigned t = min_element(load.begin(),load.end()) - load.begin();
+		owner[order[i].second] = t;
+		load[t] += grpSize[order[i].second];
+	}
+	vector<vector<unsigned>> work(threads);
+	for(unsigned i = 0; i < tasks.size(); ++i)
+		work[owner[tasks[i].grp]].push_back(i);
+
+	vector<thread> pool;
+	for(unsigned t = 1; t < threads; ++t)
+		pool.push_back(thread(&CirMgr::proveTasks, this, ref(pm[t]), cref(work[t]), ref(tasks), start, timeLimit));
+	proveTasks(pm[0],work[0],tasks,start,timeLimit);
+	for(unsigned t = 0; t < pool.size(); ++t)
+		pool[t].join();
+
+	bool timeout = false;
+	for(unsigned i = 0; i < tasks.size(); ++i){
+		FraigTask& t = tasks[i];
+		if(t.result == -2) timeout = true;
+		else if(t.result == -1) ++undecided;
+		else if(t.result == 1){
+			++disproved;
+			addCex(t.model);
+			_cexPair.push_back(pair<unsigned,unsigned>(t.id,t.rep));
+			if(_cexNum >= 64) simCex();
 		}
-		if(!result){
-			cout << "UNSAT" << flush;
-			cout << char(13) << setw(30) << ' ' << char(13);
-			p.push_back(pair<CirGate*,unsigned>(g,2*tmpList[i]+isInv));
-			_gateList[tmpList[i]] -> setFecId(-1);
-			tmpList[i] = -1;
+		else{
+			// either gate may have been merged away by an earlier rehash()
+			if(!_gates.exists(t.rep) || !_gates.exists(t.id)) continue;
+			vector<unsigned> outs;
+			unhash(t.id);
+			unhashFanOut(t.id,outs);
+			_gates.fraigMerge(t.rep,t.id,t.inv);
+			p.push_back(pair<unsigned,unsigned>(t.rep,2*t.id+t.inv));
+			_fecId[t.id] = -1;
+			rehash(outs);
 		}
 	}
-	g -> setFecId(-1);
+	return timeout;
+}
+
+// Thread body of proveRound(): prove tasks "work" on "m"
+void
+CirMgr::proveTasks(ProofModel& m,const vector<unsigned>& work,vector<FraigTask>& tasks,time_t start,unsigned timeLimit) const
+{
+	for(unsigned i = 0; i < work.size(); ++i){
+		if(timeLimit && difftime(time(0),start) >= timeLimit) return;
+		FraigTask& t = tasks[work[i]];
+		t.result = provePair(m,t.rep,t.id,t.inv);
+		if(t.result == 1) getModel(m,t.model);
+	}
+}
 
-	list -> clear();
+// Pack the PI values of the last SAT model of "m", bit i for PI i; PIs
+// outside the loaded cones read 0
+void
+CirMgr::getModel(const ProofModel& m,vector<size_t>& model) const
+{
+	if(m.circuit) getModel(m,m.aigSolver,model);
+	else getModel(m,m.solver,model);
+}
 
-	for(unsigned i = 0; i < tmpList.size(); ++i){
-		if(tmpList[i] == -1) continue;
-		list -> push_back(tmpList[i]);
+template<class S> void
+CirMgr::getModel(const ProofModel& m,const S& s,vector<size_t>& model) const
+{
+	model.assign((_PIsize + 63)/64,0);
+	for(unsigned i = 0; i < _PIsize; ++i){
+		if(m.satVar[_PIList[i]] && s.getValue(m.satVar[_PIList[i]]) == 1)
+			model[i/64] |= size_t(1) << (i%64);
 	}
-	return (oldSize - list -> size());
 }
 
+// Record a packed PI model as the next pattern of _cexPattern; patterns
+// beyond one simulation block are dropped
 void
-CirMgr::merge(vector<pair<CirGate*,unsigned>>& mergeList)
+CirMgr::addCex(const vector<size_t>& model)
+{
+	if(_cexNum == 64*_simWords) return;
+	const unsigned w = _cexNum/64;
+	const size_t bit = size_t(1) << (_cexNum%64);
+	for(unsigned i = 0; i < _PIsize; ++i){
+		if((model[i/64] >> (i%64)) & 1)
+			_cexPattern[i*_simWords + w] |= bit;
+	}
+	++_cexNum;
+}
+
+// Simulate the recorded counterexamples and refine the FEC groups; words
+// of the block that hold no counterexample get random patterns
+void
+CirMgr::simCex()
+{
+	const unsigned used = (_cexNum + 63)/64;
+	for(unsigned i = 0; i < _PIsize; ++i){
+		size_t* val = &_simValue[_PIList[i]*_simWords];
+		for(unsigned w = 0; w < used; ++w)
+			val[w] = _cexPattern[i*_simWords + w];
+		if(used < _simWords)
+			patGen.fill(val + used,_simWords - used);
+	}
+	sim(0);
+	chkFEC();
+	// A model may depend on an undefined gate, which simulates as 0; make
+	// sure every disproved candidate still leaves its representative
+	for(unsigned i = 0; i < _cexPair.size(); ++i){
+		int grp = _fecId[_cexPair[i].first];
+		if(grp != -1 && grp == _fecId[_cexPair[i].second])
+			_fecId[_cexPair[i].first] = -1;
+	}
+	_cexPair.clear();
+	_cexPattern.assign(_cexPattern.size(),0);
+	_cexNum = 0;
+}
+
+void
+CirMgr::merge(vector<pair<unsigned,unsigned>>& mergeList)
 {
 	for(unsigned i = 0; i < mergeList.size(); ++i){
-		cout << "fraig: " << (mergeList[i]).first -> getGateID() << " merging ";
-		if((mergeList[i]).second % 2 != 0) cout << "!";
-		cout << ((mergeList[i]).second / 2) << endl;
-		if((mergeList[i]).second % 2 != 0)
-			(mergeList[i]).first -> fraigMerge(_gateList[((mergeList[i]).second)/2],true);
-		else
-			(mergeList[i]).first -> fraigMerge(_gateList[((mergeList[i]).second)/2],false);
-		//--_AIGsize;
-		delete _gateList[((mergeList[i]).second)/2];
-		_gateList[((mergeList[i]).second)/2] = 0;
+		if(!_quiet){
+			cout << "fraig: " << (mergeList[i]).first << " merging ";
+			if((mergeList[i]).second % 2 != 0) cout << "!";
+			cout << ((mergeList[i]).second / 2) << endl;
+		}
+		// already rewired by proveFEC(); only the gate is left to delete
+		_gates.removeGate(((mergeList[i]).second)/2);
+	}
+	if(!mergeList.empty()) _dfsValid = false;
+}
+
+// Take AIG "g" out of _strash; return false if it was not hashed there
+bool
+CirMgr::unhash(unsigned g)
+{
+	unsigned a = _gates.getFanIn(g,0), b = _gates.getFanIn(g,1), d = 0;
+	if(!_strash.query(a,b,d) || d != g) return false;
+	_strash.remove(a,b);
+	return true;
+}
+
+// "g" is about to be replaced: unhash its AIG fanouts into "outs", for
+// rehash() to hash them again once they are rewired
+void
+CirMgr::unhashFanOut(unsigned g,vector<unsigned>& outs)
+{
+	for(unsigned e = _gates.firstFanOut(g); e != CirGateStore::NoEdge; e = _gates.nextFanOut(e)){
+		unsigned f = e/2;
+		if(_gates.isAig(f) && unhash(f)) outs.push_back(f);
+	}
+}
+
+// Hash the rewired gates of "outs" again.  A gate whose fanins are now
+// those of a hashed gate is merged with it, which rewires the fanouts in
+// turn.  The one earlier in _dfsList survives, so that the (stale) order
+// stays topological for fraig() and optimize() that are still walking it;
+// the other leaves the netlist.
+void
+CirMgr::rehash(vector<unsigned>& outs)
+{
+	while(!outs.empty()){
+		unsigned gid = outs.back();
+		outs.pop_back();
+		unsigned a = _gates.getFanIn(gid,0), b = _gates.getFanIn(gid,1);
+		unsigned repId = gid;
+		if(!_strash.queryOrInsert(a,b,repId)) continue;
+		if(_dfsPos[gid] < _dfsPos[repId]){
+			_strash.remove(a,b);
+			_strash.insert(a,b,gid);
+			swap(gid,repId);
+		}
+		if(!_quiet)
+			cout << "Strashing: " << repId << " merging " << gid << endl;
+		unhashFanOut(gid,outs);
+		_gates.fraigMerge(repId,gid,false);
+		_gates.removeGate(gid);
+		_fecId[gid] = -1;
+		--_AIGsize;
+		_dfsValid = false;
 	}
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 /****************************************************************************
   FileName     [ cirGate.cpp ]
   PackageName  [ cir ]
-  Synopsis     [ Define class CirAigGate member functions ]
+  Synopsis     [ Define the gate store and the gate reports ]
   Author       [ Chung-Yang (Ric) Huang ]
   Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
 ****************************************************************************/
@@ -19,159 +19,229 @@
 
 using namespace std;
 
-// TODO: Keep "CirGate::reportGate()", "CirGate::reportFanin()" and
-//       "CirGate::reportFanout()" for cir cmds. Feel free to define
+// TODO: Keep "CirMgr::reportGate()", "CirMgr::reportFanin()" and
+//       "CirMgr::reportFanout()" for cir cmds. Feel free to define
 //       your own variables and functions.
 
-extern CirMgr *cirMgr;
+/*******************************************/
+/*   class CirGateStore member functions   */
+/*******************************************/
+const unsigned CirGateStore::NoEdge = ~0u;
 
-/**************************************/
-/*   class CirGate member functions   */
-/**************************************/
-size_t CirGate::_globalRef = 0;
+void
+CirGateStore::init(unsigned size)
+{
+	_type.assign(size + 1,NO_GATE);
+	_line.assign(size + 1,0);
+	_fanIn.assign(2*(size + 1),0);
+	_firstOut.assign(size + 1,NoEdge);
+	_nextOut.assign(2*(size + 1),NoEdge);
+	_prevOut.assign(2*(size + 1),NoEdge);
+	_mark.assign(size + 1,0);
+	_markNum = 0;
+}
+
+void
+CirGateStore::clear()
+{
+	vector<unsigned char>().swap(_type);
+	vector<unsigned>().swap(_line);
+	vector<unsigned>().swap(_fanIn);
+	vector<unsigned>().swap(_firstOut);
+	vector<unsigned>().swap(_nextOut);
+	vector<unsigned>().swap(_prevOut);
+	vector<unsigned>().swap(_mark);
+}
+
+string
+CirGateStore::getTypeStr(unsigned gid) const
+{
+	static const char* typeStr[TOT_GATE] = { "UNDEF", "PI", "PO", "AIG", "CONST" };
+	return typeStr[_type[gid]];
+}
 
+// Put edge "i" of "gid" at the head of its driver's fanout list
 void
-CirGate::reportGate() const
+CirGateStore::linkFanIn(unsigned gid, unsigned i)
+{
+	const unsigned e = 2*gid + i, in = _fanIn[e] >> 1;
+	_prevOut[e] = NoEdge;
+	_nextOut[e] = _firstOut[in];
+	if(_firstOut[in] != NoEdge) _prevOut[_firstOut[in]] = e;
+	_firstOut[in] = e;
+}
+
+// Remove the fanout entry of fanin "i"; the fanin itself is kept
+void
+CirGateStore::unlinkFanIn(unsigned gid, unsigned i)
+{
+	const unsigned e = 2*gid + i;
+	if(_prevOut[e] != NoEdge) _nextOut[_prevOut[e]] = _nextOut[e];
+	else _firstOut[_fanIn[e] >> 1] = _nextOut[e];
+	if(_nextOut[e] != NoEdge) _prevOut[_nextOut[e]] = _prevOut[e];
+	_nextOut[e] = _prevOut[e] = NoEdge;
+}
+
+// Rewire every fanout of "gid" to "rep", inverted if "inv"
+void
+CirGateStore::takeFanOut(unsigned rep, unsigned gid, bool inv)
+{
+	while(_firstOut[gid] != NoEdge){
+		const unsigned e = _firstOut[gid];
+		unlinkFanIn(e >> 1,e & 1);
+		_fanIn[e] = 2*rep + ((_fanIn[e] & 1) != inv);
+		linkFanIn(e >> 1,e & 1);
+	}
+}
+
+// Replace "gid" by "rep" (inverted if "inv") in all its fanouts; "gid"
+// keeps its fanins but is no fanout of them any more
+void
+CirGateStore::fraigMerge(unsigned rep, unsigned gid, bool inv)
+{
+	for(unsigned i = 0; i < fanInNum(gid); ++i)
+		unlinkFanIn(gid,i);
+	takeFanOut(rep,gid,inv);
+}
+
+/*************************************************/
+/*   class CirMgr member functions about gates   */
+/*************************************************/
+void
+CirMgr::reportGate(unsigned gid) const
 {
 	stringstream ss;
 	string gateInfo = "";
-	ss << getTypeStr() << "(" << _id << ")";
-	if(_name.length())
-		ss << "\"" << _name << "\"";
-	ss << ", line " << _line;
+	ss << _gates.getTypeStr(gid) << "(" << gid << ")";
+	const string& name = getName(gid);
+	if(name.length())
+		ss << "\"" << name << "\"";
+	ss << ", line " << _gates.getLineNo(gid);
 	gateInfo = ss.str();
-	string value = getSimValue();
+	string value = getSimValueStr(gid);
 	cout << "================================================================================" << endl;
 	cout << "="; cout << " ";
 	cout << left << setw(47) << gateInfo;
 	cout << endl;
 	cout << "="; cout << " ";
-	cout << left << setw(47) << "FECs:" + getFECpair(cirMgr);
+	cout << left << setw(47) << "FECs:" + getFECpair(gid);
 	cout << endl;
 	cout << "="; cout << " ";
 	cout << left << setw(47) << "Value: " + value;
 	cout << endl;
-	cout << "================================================================================" << endl; 
+	cout << "================================================================================" << endl;
 }
 
 void
-CirGate::reportFanin(int level) const
+CirMgr::reportFanin(unsigned gid, int level) const
 {
    assert (level >= 0);
-   CirGate::IncGlobalRef();
-   cout << getTypeStr() << " " << _id << endl;
+   _gates.newMark();
+   cout << _gates.getTypeStr(gid) << " " << gid << endl;
    if(level == 0) return;
-   _ref = _globalRef;
-   for(vector<AigGateV>::const_iterator it = _fanInList.begin(); it != _fanInList.end(); ++it){
-   	reportFanin(1,level - 1,*it);
-   }
+   _gates.mark(gid);
+   for(unsigned i = 0; i < _gates.fanInNum(gid); ++i)
+   	reportFanin(1,level - 1,_gates.getFanIn(gid,i));
 }
 
 void
-CirGate::reportFanout(int level) const
+CirMgr::reportFanout(unsigned gid, int level) const
 {
    assert (level >= 0);
-   CirGate::IncGlobalRef();
-   cout << getTypeStr() << " " << _id << endl;
+   _gates.newMark();
+   cout << _gates.getTypeStr(gid) << " " << gid << endl;
    if(level == 0) return;
-   _ref = _globalRef;
-   for(vector<AigGateV>::const_iterator it = _fanOutList.begin(); it != _fanOutList.end(); ++it){
-   	reportFanout(1,level - 1,*it);
-   }
+   _gates.mark(gid);
+   vector<unsigned> outList = sortedFanOut(gid);
+   for(unsigned i = 0; i < outList.size(); ++i)
+   	reportFanout(1,level - 1,outList[i]);
 }
 
+// Report the gate of fanin literal "lit"
 void
-CirGate::reportFanin(int space,int level,AigGateV ptr) const
+CirMgr::reportFanin(int space, int level, unsigned lit) const
 {
-	for(size_t count = 0; count < space; ++count) cout << "  ";
-	if(ptr.isInv()) cout << "!";
-	cout << ptr.gate() -> getTypeStr() << " " << ptr.gate() -> getGateID();
-	if(ptr.gate() -> getTypeStr() == "PI" || ptr.gate() -> getTypeStr() == "CONST" || ptr.gate() -> getTypeStr() == "UNDEF") { cout << endl; return; }
+	const unsigned gid = lit >> 1;
+	for(int count = 0; count < space; ++count) cout << "  ";
+	if(lit & 1) cout << "!";
+	cout << _gates.getTypeStr(gid) << " " << gid;
+	if(_gates.isPi(gid) || _gates.isConst(gid) || _gates.isUndef(gid)) { cout << endl; return; }
 	if(level == 0) { cout << endl; return; }
-	if(ptr.gate() -> _ref == _globalRef) { cout << " " << "(*)" << endl; return; }
-	if(((ptr.gate()) -> _fanInList).empty()) { cout << endl; return; }
-	ptr.gate() -> _ref = _globalRef;
+	if(_gates.isMarked(gid)) { cout << " " << "(*)" << endl; return; }
+	_gates.mark(gid);
 	cout << endl;
-	for(vector<AigGateV>::const_iterator it = (ptr.gate()) -> _fanInList.begin(); it != (ptr.gate()) -> _fanInList.end(); ++it){
-		reportFanin(space + 1,level - 1, *it);
-	}
+	for(unsigned i = 0; i < _gates.fanInNum(gid); ++i)
+		reportFanin(space + 1,level - 1,_gates.getFanIn(gid,i));
 }
 
+// Report the gate of fanout edge "e"
 void
-CirGate::reportFanout(int space,int level,AigGateV ptr) const
+CirMgr::reportFanout(int space, int level, unsigned e) const
 {
-	for(size_t count = 0; count < space; ++count) cout << "  ";
-	if(ptr.isInv()) cout << "!";
-	cout << ptr.gate() -> getTypeStr() << " " << ptr.gate() -> getGateID();
-	if(ptr.gate() -> getTypeStr() == "PO") { cout << endl; return; }
+	const unsigned gid = e >> 1;
+	for(int count = 0; count < space; ++count) cout << "  ";
+	if(_gates.getFanIn(gid,e & 1) & 1) cout << "!";
+	cout << _gates.getTypeStr(gid) << " " << gid;
+	if(_gates.isPo(gid)) { cout << endl; return; }
 	if(level == 0) { cout << endl; return; }
-	if(ptr.gate() -> _ref == _globalRef) { cout << " " << "(*)" << endl; return; }
-	if(((ptr.gate()) -> _fanOutList).empty()) { cout << endl; return; }
-	ptr.gate() -> _ref = _globalRef;
+	if(_gates.isMarked(gid)) { cout << " " << "(*)" << endl; return; }
+	if(!_gates.hasFanOut(gid)) { cout << endl; return; }
+	_gates.mark(gid);
 	cout << endl;
-	for(vector<AigGateV>::const_iterator it = (ptr.gate()) -> _fanOutList.begin(); it != (ptr.gate()) -> _fanOutList.end(); ++it){
-		reportFanout(space + 1,level - 1, *it);
-	}
+	vector<unsigned> outList = sortedFanOut(gid);
+	for(unsigned i = 0; i < outList.size(); ++i)
+		reportFanout(space + 1,level - 1,outList[i]);
 }
 
-void
-CirGate::merge(CirGate* g)
+// Fanout lists are unordered; they are reported by gate id, which is
+// the order of the edge numbers
+vector<unsigned>
+CirMgr::sortedFanOut(unsigned gid) const
 {
+	vector<unsigned> list;
+	for(unsigned e = _gates.firstFanOut(gid); e != CirGateStore::NoEdge; e = _gates.nextFanOut(e))
+		list.push_back(e);
+	sort(list.begin(),list.end());
+	return list;
+}
 
-	CirGate& p1 = *((_fanInList[0]).gate());
-	for(vector<AigGateV>::iterator it = (p1._fanOutList).begin(); it != (p1._fanOutList).end(); ++it){
-		if((*it).gate() == g){
-			swap(*it,*(--(p1._fanOutList).end()));
-			(p1._fanOutList).pop_back();
-			break;
-		}
-	}
-	for(vector<AigGateV>::iterator it = (p1._fanOutList).begin(); it != (p1._fanOutList).end(); ++it){
-		if((*it).gate() == g){
-			swap(*it,*(--(p1._fanOutList).end()));
-			(p1._fanOutList).pop_back();
+void
+CirMgr::printGate(unsigned gid) const
+{
+	switch(_gates.getType(gid)){
+		case AIG_GATE:
+			cout << "AIG" << " " << gid << " ";
+			for(unsigned i = 0; i < 2; ++i){
+				const unsigned lit = _gates.getFanIn(gid,i);
+				if(_gates.isUndef(lit >> 1)) cout << "*";
+				if(lit & 1) cout << "!";
+				cout << (lit >> 1);
+				if(i < 1) cout << " ";
+			}
 			break;
-		}
-	}
-	CirGate& p2 = *((_fanInList[1]).gate());
-	for(vector<AigGateV>::iterator it = (p2._fanOutList).begin(); it != (p2._fanOutList).end(); ++it){
-		if((*it).gate() == g){
-			swap(*it,*(--(p2._fanOutList).end()));
-			(p2._fanOutList).pop_back();
+		case PI_GATE:
+			cout << "PI" << "  " << gid;
 			break;
-		}
-	}
-	for(vector<AigGateV>::iterator it = (p2._fanOutList).begin(); it != (p2._fanOutList).end(); ++it){
-		if((*it).gate() == g){
-			swap(*it,*(--(p2._fanOutList).end()));
-			(p2._fanOutList).pop_back();
+		case PO_GATE:
+			cout << "PO" << "  " << gid << " ";
+			if(_gates.isUndef(_gates.getFanInId(gid,0))) cout << "*";
+			if(_gates.getFanIn(gid,0) & 1) cout << "!";
+			cout << _gates.getFanInId(gid,0);
 			break;
-		}
-	}
-
-	for(vector<AigGateV>::iterator it = (g -> _fanOutList).begin(); it != (g -> _fanOutList).end(); ++it){
-		_fanOutList.push_back(*it);
-		if(((*it).gate()) -> getTypeStr() == "PO"){
-			POGate* ptr = (POGate*)((*it).gate());
-			if((*it).isInv())
-				ptr -> setInfo(2*_id + 1);
-			else
-				ptr -> setInfo(2*_id);
-		}
-		vector<AigGateV>::iterator v = ((*it).gate() -> _fanInList).begin();
-		if((*v).gate() != g) ++v;
-		(*v) = AigGateV(this,(*v).isInv());
-
+		case CONST_GATE:
+			cout << "CONST0" << endl;
+			return;
+		default: return;
 	}
-	(g -> _fanInList).clear();
-	(g -> _fanOutList).clear();
-	delete g;
+	const string& name = getName(gid);
+	if(name != "") cout << " " << "(" << name << ")";
+	cout << endl;
 }
 
 string
-CirGate::getSimValue() const
+CirMgr::getSimValueStr(unsigned gid) const
 {
-	bitset<64> simInfo(_pattern);
+	bitset<64> simInfo(getSimValue(gid));
 	string tmp = simInfo.to_string();
 	string str;
 	for(unsigned i = 0; i < 64;){
@@ -184,95 +254,22 @@ CirGate::getSimValue() const
 }
 
 string
-AigGate::getFECpair(const CirMgr* mgr) const
+CirMgr::getFECpair(unsigned gid) const
 {
-	if(_fecId == -1) return "";
-	if(mgr -> getFECsize() == 0) return "";
-	vector<unsigned> list = mgr -> getFEClist(_fecId);
+	int fecId = getFecId(gid);
+	if(fecId == -1) return "";
+	if(getFECsize() == 0) return "";
+	vector<unsigned> list = getFEClist(fecId);
 	sort(list.begin(),list.end());
 	string str;
 	stringstream ss;
 	for(unsigned i = 0; i < list.size(); ++i){
-		if(list[i] == _id) continue;
+		if(list[i] == gid) continue;
 		ss << " ";
-		if((mgr -> getGate(list[i]) -> getPattern()) == ~(_pattern))
+		if(getSimValue(list[i]) == ~(getSimValue(gid)))
 			ss << "!";
 		ss << list[i];
 	}
 	str = ss.str();
 	return str;
 }
-
-string
-Const0Gate::getFECpair(const CirMgr* mgr) const
-{
-	if(_fecId == -1) return "";
-	if(mgr -> getFECsize() == 0) return "";
-	vector<unsigned> list = mgr -> getFEClist(_fecId);
-	sort(list.begin(),list.end());
-	string str;
-	stringstream ss;
-	for(unsigned i = 0; i < list.size(); ++i){
-		if(list[i] == _id) continue;
-		ss << " ";
-		if((mgr -> getGate(list[i]) -> getPattern()) == ~(_pattern))
-			ss << "!";
-		ss << list[i];
-	}
-	str = ss.str();
-	return str;
-}
-
-void
-CirGate::fraigMerge(CirGate* g,bool inv)
-{
-	CirGate* p1 = (g -> _fanInList)[0].gate();
-	CirGate* p2 = (g -> _fanInList)[1].gate();
-	
-	vector<AigGateV>& p1List = p1 -> _fanOutList;
-	vector<AigGateV>& p2List = p2 -> _fanOutList;
-	for(unsigned i = 0; i < p1List.size(); ++i){
-		if(p1List[i].gate() == g){
-			swap(p1List[i],p1List[p1List.size()-1]);
-			p1List.pop_back();
-		}
-	}
-	for(unsigned i = 0; i < p1List.size(); ++i){
-		if(p1List[i].gate() == g){
-			swap(p1List[i],p1List[p1List.size()-1]);
-			p1List.pop_back();
-		}
-	}
-	for(unsigned i = 0; i < p2List.size(); ++i){
-		if(p2List[i].gate() == g){
-			swap(p2List[i],p2List[p2List.size()-1]);
-			p2List.pop_back();
-		}
-	}
-	for(unsigned i = 0; i < p2List.size(); ++i){
-		if(p2List[i].gate() == g){
-			swap(p2List[i],p2List[p2List.size()-1]);
-			p2List.pop_back();
-		}
-	}
-	
-
-	vector<AigGateV>& outList = g -> _fanOutList;
-	for(unsigned i = 0; i < outList.size(); ++i){
-		vector<AigGateV>& ls = outList[i].gate() -> _fanInList;
-		for(unsigned j = 0; j < ls.size(); ++j){
-			if(ls[j].gate() == g){
-				if((inv && !ls[j].isInv()) || (!inv && ls[j].isInv())){
-					ls[j] = AigGateV(this,1);
-					_fanOutList.push_back(AigGateV(outList[i].gate(),1));
-				}
-				else{
-					ls[j] = AigGateV(this,0);
-					_fanOutList.push_back(AigGateV(outList[i].gate(),0));
-				}
-			}
-		}
-	}
-	outList.clear();
-
-}
\ No newline at end of file
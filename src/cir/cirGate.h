@@ -13,236 +13,81 @@
 #include <vector>
 #include <iostream>
 #include "cirDef.h"
-#include "sat.h"
 
 using namespace std;
 
-class CirGate;
-class AigGateV;
-class AigGate;
-class PIGate;
-class POGate;
-class Const0Gate;
-class UnDefGate;
-
 //------------------------------------------------------------------------
 //   Define classes
 //------------------------------------------------------------------------
 // TODO: Define your own data members and member functions, or classes
 
 //------------------------------------------------------------------------
-//   class AigGateV
+//   class CirGateStore
 //------------------------------------------------------------------------
+// The netlist as one array per attribute, indexed by gate id; a gate is
+// only its id.  Fanins are AIGER literals (2*id, plus 1 if inverted):
+// fanin i of gate g is edge 2*g+i, an AIG has two, a PO one.
+// The fanouts of a gate are the edges that read it, in a list threaded
+// through _nextOut/_prevOut, so an edge is added or removed in constant
+// time without any per-gate allocation.  Fanout lists are thus unordered.
 
-class AigGateV{
-  friend class CirGate;
-  friend class AigGate;
-  friend class PIGate;
-  friend class POGate;
-  friend class Const0Gate;
-  friend class UnDefGate;
-  friend class CirMgr;
-  #define NEG 0x1
-public:
-  bool operator == (const AigGateV& ptr) const { return (_gateV == ptr._gateV); }
-  size_t operator & (const AigGateV& g) const { return (_gateV & g._gateV); }
-
-  AigGateV(CirGate* g, size_t phase): _gateV(size_t(g) + phase) {}
-  CirGate* gate() const {return (CirGate*)(_gateV & ~size_t(NEG));}
-  bool isInv() const {return (_gateV & NEG);}
-private:
-  size_t _gateV;
-};
-
-//------------------------------------------------------------------------
-//   class CirGate
-//------------------------------------------------------------------------
-
-class CirGate
+class CirGateStore
 {
 public:
-   CirGate() {}
-   virtual ~CirGate() {}
-
-   // Basic access methods
-   virtual string getTypeStr() const = 0;
-   unsigned getLineNo() const { return _line; }
-   unsigned getGateID() const { return _id; }
-   size_t& getRef() const { return _ref; }
-   string getName() const { return _name; }
-   vector<AigGateV>& getFanInList() { return _fanInList; }
-   vector<AigGateV>& getFanOutList() { return _fanOutList; }
-   size_t& getPattern() { return _pattern; }
-   virtual int getFec() { return -1; }
-   virtual Var& getVar() { return _var; }
-   static size_t& getGlobalRef() { return _globalRef; }
-   virtual bool isAig() const { return false; }
-
-   // Printing functions
-   virtual void printGate() const = 0;
-   void reportGate() const;
-   void reportFanin(int level) const;
-   void reportFanout(int level) const;
-
-   //setting functions
-   void push_fanInList(AigGateV ptr) { _fanInList.push_back(ptr); }
-   void push_fanOutList(AigGateV ptr) { _fanOutList.push_back(ptr); }
-   //void setFanIn(size_t& pos, AigGateV ptr) { _fanInList[pos] = ptr; }
-   void setName(string& str) { _name = str; }
-   void setRef(size_t num) const { _ref = num; }
-   void merge(CirGate*);
-   void fraigMerge(CirGate*,bool);
-   void setPattern(size_t& p) { _pattern = p; }
-   void resetPattern() { _pattern = 0; }
-   virtual void setFecId(int&) {}
-   virtual void setFecId(int) {}
-   virtual void setVar(Var& v) { _var = v; }
-   virtual void simulation() {}
-   virtual void updateInfo() {}
-   virtual void updateFanIn(size_t&) {}
-   static void IncGlobalRef() { ++_globalRef; }
-
-private:
-   void reportFanin(int,int,AigGateV) const;
-   void reportFanout(int,int,AigGateV) const;
-   virtual string getFECpair(const CirMgr*) const { return ""; };
-   string getSimValue() const;
-
-protected:
-   string _name;
-   unsigned _id;
-   unsigned _line;
-   vector<AigGateV> _fanInList;
-   vector<AigGateV> _fanOutList;
-   size_t _pattern;
-   Var _var;
-   mutable size_t _ref;
-   static size_t _globalRef;
-};
-
-
-//------------------------------------------------------------------------
-//   class AigGate
-//------------------------------------------------------------------------
-
-class AigGate : public CirGate {
-public:
-   AigGate(unsigned i,unsigned l) { _name = ""; _id = i; _line = l; _ref = 0; _pattern = 0; _fecId = 0; }
-   ~AigGate() {}
-   string getTypeStr() const { return "AIG"; }
-   bool isAig() const { return true; }
-   void setFEC(int& n) { _fecId = n; }
-   int getFec() { return _fecId; }
-   void setFecId(int& n) { _fecId = n; }
-   void setFecId(int n) { _fecId = n; }
-   Var& getVar() { return _var; }
-   void setVar(Var& v) { _var = v; }
-   void updateFanIn(size_t& pos) { if(pos == 0) swap(_fanInList[0],_fanInList[1]); }
-   void printGate() const {
-    cout << "AIG" << " " << _id << " ";
-    for(short i = 0; i < 2; ++i){
-      if(_fanInList[i].gate() -> getTypeStr() == "UNDEF") cout << "*";
-      if(_fanInList[i].isInv()) cout << "!";
-      cout << _fanInList[i].gate() -> getGateID();
-      if(i < 1) cout << " ";
-    }
-    if(_name != "") cout << " " << "(" << _name << ")";
-    cout << endl;  
-   }
-   void simulation(){
-    size_t p1 = (_fanInList[0].gate()) -> getPattern();
-    size_t p2 = (_fanInList[1].gate()) -> getPattern();
-    if(_fanInList[0].isInv()) p1 = ~p1;
-    if(_fanInList[1].isInv()) p2 = ~p2;
-    _pattern = p1 & p2;
-   }
- private:
-  string getFECpair(const CirMgr*) const;
-  int _fecId;
-};
-
-//------------------------------------------------------------------------
-//   class PIGate
-//------------------------------------------------------------------------
-
-class PIGate : public CirGate {
-public:
-   PIGate(unsigned i,unsigned l) { _name = ""; _id = i; _line = l; _ref = 0; _pattern = 0; }
-   ~PIGate() {}
-   string getTypeStr() const { return "PI"; }
-   Var& getVar() { return _var; }
-   void setVar(Var& v) { _var = v; }
-   void printGate() const {
-    cout << "PI" << "  " << _id;
-    if(_name != "") cout << " " << "(" << _name << ")";
-    cout << endl;
-   }
-private:
-};
-
-//------------------------------------------------------------------------
-//   class POGate
-//------------------------------------------------------------------------
+   static const unsigned NoEdge;
 
-class POGate : public CirGate {
-public:
-   POGate(unsigned i,unsigned l,size_t p) : _out(p) { _name = ""; _id = i; _line = l; _ref = 0; _pattern = 0; }
-   ~POGate() {}
-   string getTypeStr() const { return "PO"; }
-   bool isInv() const { return (_out%2 != 0); }
-   size_t outGateIdx() const { return _out/2; }
-   size_t getInfo() const { return _out; }
-   void setInfo(size_t n) { _out = n; }
-   void updateInfo() { _out = 2*((_fanInList[0]).gate() -> getGateID()); if((_fanInList[0]).isInv()) ++_out; }
-   void printGate() const {
-    cout << "PO" << "  " << _id << " ";
-    if(_fanInList[0].gate() -> getTypeStr() == "UNDEF") cout << "*";
-    if(isInv()) cout << "!";
-    cout << _out/2;
-    if(_name != "") cout << " " << "(" << _name << ")";
-    cout << endl;
-   }
-   void simulation(){ _pattern = _fanInList[0].gate() -> getPattern(); if(isInv()) _pattern = ~_pattern; }
-private:
-   size_t _out;  
-};
+   CirGateStore(): _markNum(0) {}
 
-//------------------------------------------------------------------------
-//   class Const0Gate
-//------------------------------------------------------------------------
+   // Ids 0..size, none of them in use
+   void init(unsigned size);
+   void clear();
 
-class Const0Gate : public CirGate {
-public:
-   Const0Gate(unsigned i,unsigned l) { _name = ""; _id = i; _line = l; _ref = 0; _pattern = 0; _fecId = 0; }
-   ~Const0Gate() {}
-   string getTypeStr() const { return "CONST"; }
-   int getFec() { return _fecId; }
-   void setFecId(int& n) { _fecId = n; }
-   void setFecId(int n) { _fecId = n; }
-   Var& getVar() { return _var; }
-   void setVar(Var& v) { _var = v; }
-   void printGate() const {
-    cout << "CONST0" << endl;
+   // Basic access methods
+   GateType getType(unsigned gid) const { return GateType(_type[gid]); }
+   string getTypeStr(unsigned gid) const;
+   unsigned getLineNo(unsigned gid) const { return _line[gid]; }
+   bool exists(unsigned gid) const { return gid < _type.size() && _type[gid] != NO_GATE; }
+   bool isAig(unsigned gid) const { return _type[gid] == AIG_GATE; }
+   bool isPi(unsigned gid) const { return _type[gid] == PI_GATE; }
+   bool isPo(unsigned gid) const { return _type[gid] == PO_GATE; }
+   bool isConst(unsigned gid) const { return _type[gid] == CONST_GATE; }
+   bool isUndef(unsigned gid) const { return _type[gid] == UNDEF_GATE; }
+   unsigned fanInNum(unsigned gid) const {
+      return isAig(gid)? 2: isPo(gid)? 1: 0;
    }
-private:
-  string getFECpair(const CirMgr*) const;
-  int _fecId;
-};
-
-//------------------------------------------------------------------------
-//   class UnDefGate
-//------------------------------------------------------------------------
+   unsigned getFanIn(unsigned gid, unsigned i) const { return _fanIn[2*gid + i]; }
+   unsigned getFanInId(unsigned gid, unsigned i) const { return _fanIn[2*gid + i] >> 1; }
+   // Fanout edges: for (e = firstFanOut(g); e != NoEdge; e = nextFanOut(e))
+   // the fanout is gate e/2, reading "g" as its fanin e%2
+   unsigned firstFanOut(unsigned gid) const { return _firstOut[gid]; }
+   unsigned nextFanOut(unsigned e) const { return _nextOut[e]; }
+   bool hasFanOut(unsigned gid) const { return _firstOut[gid] != NoEdge; }
+
+   // Traversal marks; newMark() unmarks every gate
+   void newMark() const { ++_markNum; }
+   bool isMarked(unsigned gid) const { return _mark[gid] == _markNum; }
+   void mark(unsigned gid) const { _mark[gid] = _markNum; }
+
+   // Setting functions
+   void addGate(unsigned gid, GateType t, unsigned line) { _type[gid] = t; _line[gid] = line; }
+   void removeGate(unsigned gid) { _type[gid] = NO_GATE; }
+   // Fanin "i" without its fanout entry; see linkFanIn()
+   void initFanIn(unsigned gid, unsigned i, unsigned lit) { _fanIn[2*gid + i] = lit; }
+   void linkFanIn(unsigned gid, unsigned i);
+   void unlinkFanIn(unsigned gid, unsigned i);
+   void fraigMerge(unsigned rep, unsigned gid, bool inv);
 
-class UnDefGate : public CirGate {
-public:
-   UnDefGate(unsigned i) { _name = ""; _id = i; _line = 0; _ref = 0; _pattern = 0; }  
-   ~UnDefGate() {}
-   string getTypeStr() const { return "UNDEF"; }
-   void printGate() const {}
-   Var& getVar() { return _var; }
-   void setVar(Var& v) { _var = v; }
 private:
+   void takeFanOut(unsigned rep, unsigned gid, bool inv);
+
+   vector<unsigned char> _type; // GateType, NO_GATE if the id is unused
+   vector<unsigned> _line;
+   vector<unsigned> _fanIn; // 2 per gate
+   vector<unsigned> _firstOut; // per gate
+   vector<unsigned> _nextOut; // per edge
+   vector<unsigned> _prevOut; // per edge
+   mutable vector<unsigned> _mark;
+   mutable unsigned _markNum;
 };
 
-
 #endif // CIR_GATE_H
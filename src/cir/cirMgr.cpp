@@ -8,11 +8,17 @@
 
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <algorithm>
 #include <cstdio>
 #include <ctype.h>
 #include <cassert>
 #include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "util.h"
@@ -57,7 +63,7 @@ static unsigned colNo  = 0;  // in printing, colNo needs to ++
 static char buf[1024];
 static string errMsg;
 static int errInt;
-static CirGate *errGate;
+static unsigned errLine;
 
 static bool
 parseError(CirParseError err)
@@ -122,7 +128,7 @@ parseError(CirParseError err)
       case REDEF_GATE:
          cerr << "[ERROR] Line " << lineNo+1 << ": Literal \"" << errInt
               << "\" is redefined, previously defined as "
-              << errGate->getTypeStr() << " in line " << errGate->getLineNo()
+              << errMsg << " in line " << errLine
               << "!!" << endl;
          break;
       case REDEF_SYMBOLIC_NAME:
@@ -146,6 +152,160 @@ parseError(CirParseError err)
    return false;
 }
 
+// The AIGER file is memory-mapped and scanned in place; "cur" walks over
+// the mapped bytes and the read*() helpers below advance it, keeping
+// lineNo/colNo in sync so that parseError() reports the right position.
+static const char *cur = 0;
+static const char *eof = 0;
+static unsigned numCol = 0;  // column where the last number begins
+
+static bool
+readSpace()
+{
+   if (cur == eof || *cur != ' ') {
+      if (cur != eof && *cur != '\n' && isspace(*cur)) {
+         errInt = *cur;
+         return parseError(ILLEGAL_WSPACE);
+      }
+      return parseError(MISSING_SPACE);
+   }
+   ++cur; ++colNo;
+   return true;
+}
+
+static bool
+readNewline()
+{
+   if (cur == eof || *cur != '\n') return parseError(MISSING_NEWLINE);
+   ++cur; ++lineNo; colNo = 0;
+   return true;
+}
+
+// Scan an unsigned decimal number straight out of the mapped bytes;
+// numbers beyond the literal range (UINT_MAX/2) are illegal
+static bool
+readNum(unsigned& num, const char* what)
+{
+   if (cur != eof && *cur == ' ') return parseError(EXTRA_SPACE);
+   if (cur != eof && *cur != '\n' && isspace(*cur)) {
+      errInt = *cur;
+      return parseError(ILLEGAL_WSPACE);
+   }
+   if (cur == eof || *cur == '\n') {
+      errMsg = what;
+      return parseError(MISSING_NUM);
+   }
+   const char *beg = cur;
+   num = 0;
+   for (; cur != eof && !isspace(*cur); ++cur) {
+      unsigned digit = unsigned(*cur - '0');
+      if (!isdigit(*cur) || num > (UINT_MAX/2 - digit) / 10) {
+         while (cur != eof && !isspace(*cur)) ++cur;
+         errMsg = string(what) + "(" + string(beg, cur) + ")";
+         return parseError(ILLEGAL_NUM);
+      }
+      num = num * 10 + digit;
+   }
+   numCol = colNo;
+   colNo += cur - beg;
+   return true;
+}
+
+// "aag M I L O A" (ASCII) or "aig M I L O A" (binary)
+static bool
+readHeader(unsigned* info, bool& binary)
+{
+   static const char* numName[5] = { "number of variables", "number of PIs",
+      "number of latches", "number of POs", "number of AIGs" };
+   const char *beg = cur;
+   while (cur != eof && !isspace(*cur)) ++cur;
+   if (cur == beg) {
+      errMsg = "aag";
+      return parseError(MISSING_IDENTIFIER);
+   }
+   errMsg = string(beg, cur);
+   if (errMsg != "aag" && errMsg != "aig")
+      return parseError(ILLEGAL_IDENTIFIER);
+   binary = (errMsg == "aig");
+   colNo += cur - beg;
+   for (unsigned i = 0; i < 5; ++i)
+      if (!readSpace() || !readNum(info[i], numName[i])) return false;
+   if (info[2] != 0) {
+      errMsg = "Number of latches"; errInt = info[2];
+      return parseError(NUM_TOO_BIG);
+   }
+   // summed in 64 bits so that huge counts cannot wrap around
+   const unsigned long long defined = (unsigned long long)info[1] + info[2] + info[4];
+   if (info[0] < defined) {
+      errMsg = "Number of variables"; errInt = info[0];
+      return parseError(NUM_TOO_SMALL);
+   }
+   // binary AIGER numbers every variable implicitly
+   if (binary && info[0] > defined) {
+      errMsg = "Number of variables"; errInt = info[0];
+      return parseError(NUM_TOO_BIG);
+   }
+   return readNewline();
+}
+
+// Decode one LEB128-style delta of a binary AND gate
+static bool
+readDelta(unsigned& delta)
+{
+   delta = 0;
+   for (unsigned shift = 0; ; shift += 7) {
+      if (cur == eof) {
+         errMsg = "AIG delta";
+         return parseError(MISSING_NUM);
+      }
+      unsigned char ch = *cur++;
+      if (shift > 28 || (shift == 28 && (ch & 0x70))) {
+         errMsg = "AIG delta";
+         return parseError(ILLEGAL_NUM);
+      }
+      delta |= unsigned(ch & 0x7f) << shift;
+      if (!(ch & 0x80)) return true;
+   }
+}
+
+static void
+writeDelta(ostream& outfile, unsigned delta)
+{
+   while (delta & ~0x7fu) {
+      outfile.put(char((delta & 0x7f) | 0x80));
+      delta >>= 7;
+   }
+   outfile.put(char(delta));
+}
+
+// Check the literal "lit" that is about to define a PI or AIG gate
+static bool
+checkDefLit(unsigned lit, unsigned maxId, const CirGateStore& gates,
+            const char* type)
+{
+   CirParseError err = DUMMY_END;
+   if (lit / 2 == 0) err = REDEF_CONST;
+   else if (lit % 2) { errMsg = type; err = CANNOT_INVERTED; }
+   else if (lit / 2 > maxId) err = MAX_LIT_ID;
+   else if (gates.exists(lit / 2)) {
+      errMsg = gates.getTypeStr(lit / 2); errLine = gates.getLineNo(lit / 2);
+      err = REDEF_GATE;
+   }
+   if (err == DUMMY_END) return true;
+   colNo = numCol;
+   errInt = lit;
+   return parseError(err);
+}
+
+static bool
+checkMaxLit(unsigned lit, unsigned maxId)
+{
+   if (lit / 2 <= maxId) return true;
+   colNo = numCol;
+   errInt = lit;
+   return parseError(MAX_LIT_ID);
+}
+
 
 /**************************************************************/
 /*   class CirMgr member functions for circuit construction   */
@@ -153,125 +313,285 @@ parseError(CirParseError err)
 bool
 CirMgr::readCircuit(const string& fileName)
 {
-  ifstream cirFile;
-  string str;
-  cirFile.open(fileName);
+  int fd = open(fileName.c_str(),O_RDONLY);
+  if(fd < 0){
+    cerr << "Cannot open design \"" << fileName << "\"!!" << endl;
+    return false;
+  }
+  struct stat st;
+  if(fstat(fd,&st) < 0){
+    cerr << "Cannot open design \"" << fileName << "\"!!" << endl;
+    close(fd);
+    return false;
+  }
+
+  size_t len = st.st_size;
+  void* data = 0;
+  if(len){
+    data = mmap(0,len,PROT_READ,MAP_PRIVATE,fd,0);
+    if(data == MAP_FAILED){
+      cerr << "Cannot map design \"" << fileName << "\"!!" << endl;
+      close(fd);
+      return false;
+    }
+    madvise(data,len,MADV_SEQUENTIAL);
+  }
+
+  lineNo = colNo = 0;
+  cur = (const char*)data;
+  eof = cur + len;
+  bool ok = parseAag();
+
+  if(data) munmap(data,len);
+  close(fd);
+  cur = eof = 0;
+  return ok;
+}
 
-  if(!cirFile.is_open()) return false;
+// Read "file1" and "file2" into one circuit for equivalence checking.
+// The PIs are shared by position; the POs of "file1" come first, then
+// those of "file2".  Both are renumbered as in writeAig(), so floating
+// fanins become constant 0.
+bool
+CirMgr::readMiter(const string& file1, const string& file2)
+{
+  CirMgr c[2];
+  if(!c[0].readCircuit(file1) || !c[1].readCircuit(file2)) return false;
+  if(c[0]._PIsize != c[1]._PIsize || c[0]._POsize != c[1]._POsize){
+    cerr << "Error: \"" << file1 << "\" and \"" << file2
+         << "\" differ in the number of PIs or POs!!" << endl;
+    return false;
+  }
 
-  getline(cirFile,str);
-  vector<string> headerInfoStr;
-  lexOptions(str,headerInfoStr,6);
+  const size_t piNum = c[0]._PIsize, poNum = c[0]._POsize;
+  vector<int> aigList[2];
+  vector<unsigned> newId[2];
+  size_t aigNum = 0;
+  for(size_t k = 0; k < 2; ++k){
+    aigList[k] = c[k].getAigList();
+    newId[k].assign(c[k]._size + 1,0);
+    for(size_t count = 0; count < piNum; ++count)
+      newId[k][c[k]._PIList[count]] = count + 1;
+    for(size_t count = 0; count < aigList[k].size()/3; ++count)
+      newId[k][aigList[k][3*count]/2] = piNum + ++aigNum;
+  }
 
-  for(size_t count = 1; count < 6; ++count){
-    int info = 0;
-    myStr2Int(headerInfoStr[count],info);
-    headerInfo.push_back(info);
+  ostringstream aag;
+  aag << "aag " << piNum + aigNum << " " << piNum << " 0 " << 2*poNum
+      << " " << aigNum << "\n";
+  for(size_t count = 0; count < piNum; ++count)
+    aag << 2*(count + 1) << "\n";
+  for(size_t k = 0; k < 2; ++k){
+    for(size_t count = 0; count < poNum; ++count){
+      size_t lit = c[k]._gates.getFanIn(c[k]._POList[count],0);
+      aag << 2*newId[k][lit/2] + lit%2 << "\n";
+    }
+  }
+  for(size_t k = 0; k < 2; ++k){
+    const vector<int>& list = aigList[k];
+    for(size_t count = 0; count < list.size(); ++count){
+      aag << 2*newId[k][list[count]/2] + list[count]%2;
+      aag << ((count%3 == 2)? "\n": " ");
+    }
   }
+  for(size_t count = 0; count < piNum; ++count){
+    if(c[0].getName(c[0]._PIList[count]) != "")
+      aag << "i" << count << " " << c[0].getName(c[0]._PIList[count]) << "\n";
+  }
+  for(size_t k = 0; k < 2; ++k){
+    for(size_t count = 0; count < poNum; ++count){
+      if(c[k].getName(c[k]._POList[count]) != "")
+        aag << "o" << k*poNum + count << " "
+            << c[k].getName(c[k]._POList[count]) << "\n";
+    }
+  }
+
+  const string text = aag.str();
+  lineNo = colNo = 0;
+  cur = text.data();
+  eof = cur + text.size();
+  bool ok = parseAag();
+  cur = eof = 0;
+  return ok;
+}
+
+bool
+CirMgr::parseAag()
+{
+  unsigned info[5]; //M I L O A
+  bool binary = false;
+  if(!readHeader(info,binary)) return false;
+  for(size_t count = 0; count < 5; ++count)
+    headerInfo.push_back(info[count]);
 
   _size = headerInfo[0] + headerInfo[3];
   _PIsize = headerInfo[1];
   _POsize = headerInfo[3];
   _AIGsize = headerInfo[4];
 
-  _gateList = new CirGate*[_size + 1];
-  for(size_t count = 0; count <= _size; ++count)
-    _gateList[count] = 0;
-  _PIList = new size_t[_PIsize];
-  _POList = new size_t[_POsize];
-  _AIGList = new size_t[_AIGsize];
+  _gates.init(_size);
+  _PIList.resize(_PIsize);
+  _POList.resize(_POsize);
 
-  _gateList[0] = new Const0Gate(0,0);
+  _simValue.assign((_size + 1)*_simWords,0);
+  _fecId.assign(_size + 1,-1);
 
-  str.clear();
+  _gates.addGate(0,CONST_GATE,0);
+  _fecId[0] = 0;
 
+  // In binary AIGER the PIs are implicitly 2, 4, ..., 2I and the AIGs
+  // follow them; such gates get the line numbers they would have in the
+  // equivalent ASCII file.
   for(size_t count = 0; count < _PIsize; ++count){
-    string input;
-    int gid = 0;
-    getline(cirFile,input);
-    myStr2Int(input,gid); gid/=2;
-    _gateList[gid] = new PIGate(gid,count + 2);
-    _PIList[count] = gid;
+    if(binary){
+      _gates.addGate(count + 1,PI_GATE,count + 2);
+      _PIList[count] = count + 1;
+      continue;
+    }
+    unsigned lit = 0;
+    if(!readNum(lit,"PI literal ID")) return false;
+    if(!checkDefLit(lit,info[0],_gates,"PI")) return false;
+    _gates.addGate(lit/2,PI_GATE,lineNo + 1);
+    _PIList[count] = lit/2;
+    if(!readNewline()) return false;
   }
 
   for(size_t count = 1; count <= _POsize; ++count){
-    string output;
-    int gid = 0;
-    getline(cirFile,output);
-    myStr2Int(output,gid);
-    _gateList[headerInfo[0] + count] = new POGate(headerInfo[0] + count, count + _PIsize + 1,gid);
+    unsigned lit = 0;
+    if(!readNum(lit,"PO literal ID")) return false;
+    if(!checkMaxLit(lit,info[0])) return false;
+    _gates.addGate(headerInfo[0] + count,PO_GATE,binary? _PIsize + count + 1: lineNo + 1);
+    _gates.initFanIn(headerInfo[0] + count,0,lit);
     _POList[count - 1] = headerInfo[0] + count;
+    if(!readNewline()) return false;
   }
 
-  size_t** AigInfo = new size_t*[_AIGsize];
-  for(size_t i = 0; i < _AIGsize; ++i) AigInfo[i] = new size_t[3];
-
+  // ids of the AIGs in file order
+  IdList aigList(_AIGsize);
   for(size_t count = 0; count < _AIGsize; ++count){
-    string aigInfo;
-    vector<string> tokens;
-    getline(cirFile,aigInfo);
-    lexOptions(aigInfo,tokens,3);
-    int gid = 0, pi1 = 0, pi2 = 0;
-    myStr2Int(tokens[0],gid); gid/=2; AigInfo[count][0] = gid;
-    myStr2Int(tokens[1],pi1); AigInfo[count][1] = pi1;
-    myStr2Int(tokens[2],pi2); AigInfo[count][2] = pi2;
-
-    _gateList[gid] = new AigGate(gid,count + _PIsize + _POsize + 2);
-    _AIGList[count] = gid;
+    unsigned aig[3]; // lhs/2, rhs0, rhs1
+    if(binary){
+      unsigned delta0 = 0, delta1 = 0;
+      aig[0] = _PIsize + count + 1;
+      if(!readDelta(delta0) || !readDelta(delta1)) return false;
+      if(delta0 == 0 || delta0 > 2*aig[0] || delta1 > 2*aig[0] - delta0){
+        errMsg = "AIG delta";
+        return parseError(ILLEGAL_NUM);
+      }
+      aig[1] = 2*aig[0] - delta0;
+      aig[2] = aig[1] - delta1;
+      _gates.addGate(aig[0],AIG_GATE,_PIsize + _POsize + count + 2);
+    }
+    else{
+      if(!readNum(aig[0],"AIG gate literal ID")) return false;
+      if(!checkDefLit(aig[0],info[0],_gates,"AIG")) return false;
+      aig[0] /= 2;
+      _gates.addGate(aig[0],AIG_GATE,lineNo + 1);
+      for(size_t i = 1; i < 3; ++i){
+        if(!readSpace() || !readNum(aig[i],"AIG input literal ID")) return false;
+        if(!checkMaxLit(aig[i],info[0])) return false;
+      }
+      if(!readNewline()) return false;
+    }
+    _gates.initFanIn(aig[0],0,aig[1]);
+    _gates.initFanIn(aig[0],1,aig[2]);
+    aigList[count] = aig[0];
+    _fecId[aig[0]] = 0;
   }
 
+  // fanins that are defined nowhere are UNDEF gates
   for(size_t count = 0; count < _POsize; ++count){
-    POGate* ptr = (POGate*)_gateList[_POList[count]];
-    size_t idx = ptr -> outGateIdx();
-    bool isInv = ptr -> isInv();
-    if(!_gateList[idx])
-      _gateList[idx] = new UnDefGate(idx);
-    _gateList[idx] -> push_fanOutList(AigGateV(_gateList[_POList[count]],isInv));
-    _gateList[_POList[count]] -> push_fanInList(AigGateV(_gateList[idx],isInv));
+    unsigned idx = _gates.getFanInId(_POList[count],0);
+    if(!_gates.exists(idx)) _gates.addGate(idx,UNDEF_GATE,0);
   }
-
-  for(size_t count = 0; count < _AIGsize; ++count){
-    if(!_gateList[AigInfo[count][1]/2]) _gateList[AigInfo[count][1]/2] = new UnDefGate(AigInfo[count][1]/2);
-    if(!_gateList[AigInfo[count][2]/2]) _gateList[AigInfo[count][2]/2] = new UnDefGate(AigInfo[count][2]/2);
-    _gateList[AigInfo[count][0]] -> push_fanInList(AigGateV(_gateList[AigInfo[count][1]/2],AigInfo[count][1]%2));
-    _gateList[AigInfo[count][0]] -> push_fanInList(AigGateV(_gateList[AigInfo[count][2]/2],AigInfo[count][2]%2));
-    _gateList[AigInfo[count][1]/2] -> push_fanOutList(AigGateV(_gateList[AigInfo[count][0]],AigInfo[count][1]%2));
-    _gateList[AigInfo[count][2]/2] -> push_fanOutList(AigGateV(_gateList[AigInfo[count][0]],AigInfo[count][2]%2));
+  for(size_t count = 0; count < aigList.size(); ++count){
+    for(size_t i = 0; i < 2; ++i){
+      unsigned idx = _gates.getFanInId(aigList[count],i);
+      if(!_gates.exists(idx)) _gates.addGate(idx,UNDEF_GATE,0);
+    }
   }
 
-  for(size_t count = 0; count <= _size; ++count){
-    if(!_gateList[count]) continue;
-    sort((_gateList[count] -> getFanOutList()).begin(),(_gateList[count] -> getFanOutList()).end(),sortFanOut);
-
+  // Hash-cons the AIGs in topological order (the PO cones first, then the
+  // unused gates in file order): an AIG whose fanins are those of an
+  // earlier one is never hooked up, and its fanouts read the earlier one
+  // through "same".  Fanout lists are only built here, from the survivors.
+  IdList order;
+  _gates.newMark();
+  for(size_t count = 0; count < _POsize; ++count)
+    dfs(_POList[count],order);
+  for(size_t count = 0; count < aigList.size(); ++count)
+    dfs(aigList[count],order);
+  IdList same(_size + 1,0);
+  _strash.init(_AIGsize);
+  for(size_t count = 0; count < order.size(); ++count){
+    unsigned gid = order[count], repId = gid;
+    if(!_gates.isAig(gid)) continue;
+    for(size_t i = 0; i < 2; ++i){
+      unsigned lit = _gates.getFanIn(gid,i);
+      if(same[lit/2]) _gates.initFanIn(gid,i,2*same[lit/2] + lit%2);
+    }
+    if(_strash.queryOrInsert(_gates.getFanIn(gid,0),_gates.getFanIn(gid,1),repId)){
+      same[gid] = repId;
+      _gates.removeGate(gid);
+      _fecId[gid] = -1;
+      --_AIGsize;
+      continue;
+    }
+    _gates.linkFanIn(gid,0);
+    _gates.linkFanIn(gid,1);
   }
-
-  while(!cirFile.eof()){
-    getline(cirFile,str);
-    vector<string> tokens;
-    bool doInput = false;
-
-    if(str == "c" || str.length() == 0) break;
-    if(str[0] == 'i') doInput = true;
-    str.erase(str.begin());
-    int i = 0;
-    vector<string> varInfo;
-    lexOptions(str,varInfo);
-    int idx = 0;
-    myStr2Int(varInfo[0],idx);
-    str.erase(str.begin(),str.begin() + varInfo[0].length() + 1);
-    if(doInput)
-      _gateList[_PIList[idx]] -> setName(str);
-    else
-      _gateList[_POList[idx]] -> setName(str);
+  for(size_t count = 0; count < _POsize; ++count){
+    unsigned lit = _gates.getFanIn(_POList[count],0);
+    if(same[lit/2]) _gates.initFanIn(_POList[count],0,2*same[lit/2] + lit%2);
+    _gates.linkFanIn(_POList[count],0);
   }
 
-
-
-  cirFile.close();
+  // symbols: "i<idx> <name>" / "o<idx> <name>", up to the comment section
+  while(cur != eof && *cur != '\n' && *cur != 'c'){
+    char type = *cur;
+    if(type != 'i' && type != 'o'){
+      errMsg = type;
+      return parseError(ILLEGAL_SYMBOL_TYPE);
+    }
+    ++cur; ++colNo;
+    unsigned idx = 0;
+    if(!readNum(idx,"symbol index")) return false;
+    if(idx >= (type == 'i'? _PIsize: _POsize)){
+      errMsg = (type == 'i'? "PI index": "PO index"); errInt = idx;
+      return parseError(NUM_TOO_BIG);
+    }
+    if(!readSpace()) return false;
+    const char* beg = cur;
+    for(; cur != eof && *cur != '\n'; ++cur, ++colNo){
+      if(!isprint(*cur)){
+        errInt = *cur;
+        return parseError(ILLEGAL_SYMBOL_NAME);
+      }
+    }
+    if(cur == beg){
+      errMsg = "symbolic name";
+      return parseError(MISSING_IDENTIFIER);
+    }
+    unsigned gid = (type == 'i'? _PIList[idx]: _POList[idx]);
+    if(_nameList.count(gid)){
+      errMsg = type; errInt = idx;
+      return parseError(REDEF_SYMBOLIC_NAME);
+    }
+    _nameList[gid] = string(beg,cur);
+    if(cur != eof && !readNewline()) return false;
+  }
 
   return true;
 }
 
+const string&
+CirMgr::getName(unsigned gid) const
+{
+  static const string noName;
+  map<unsigned,string>::const_iterator it = _nameList.find(gid);
+  return (it == _nameList.end())? noName: it -> second;
+}
+
 /**********************************************************/
 /*   class CirMgr member functions for circuit printing   */
 /**********************************************************/
@@ -308,34 +628,19 @@ CirMgr::printNetlist() const
    }
 */
 
+  IdList list;
+  _gates.newMark();
+  for(size_t count = 0; count < _POsize; ++count)
+    dfs(_POList[count],list);
+
   int num = 0;
-  CirGate::IncGlobalRef();
   cout << endl;
-  for(size_t count = 0; count < _POsize; ++count){
-    for(vector<AigGateV>::const_iterator it = (_gateList[_POList[count]] -> getFanInList()).begin(); it != (_gateList[_POList[count]] -> getFanInList()).end(); ++it){
-      printNetlist(*it,num);
-    }
+  for(size_t count = 0; count < list.size(); ++count){
+    if(_gates.isUndef(list[count])) continue;
     cout << "[" << num << "]" << " ";
-    _gateList[_POList[count]] -> printGate();
-    _gateList[_POList[count]] -> setRef(CirGate::getGlobalRef());
+    printGate(list[count]);
     ++num;
-    //cout << endl;
   }
-  
-}
-
-void
-CirMgr::printNetlist(AigGateV ptr,int& num) const
-{
-  if(ptr.gate() -> getRef() == CirGate::getGlobalRef()) return;
-  if(ptr.gate() -> getTypeStr() == "UNDEF") return;
-  for(vector<AigGateV>::const_iterator it = (ptr.gate() -> getFanInList()).begin(); it != (ptr.gate() -> getFanInList()).end(); ++it)
-    printNetlist(*it,num);
-  cout << "[" << num << "]" << " ";
-  ptr.gate() -> printGate();
-  ptr.gate() -> setRef(CirGate::getGlobalRef());
-  //cout << endl;
-  ++num;
 }
 
 void
@@ -367,11 +672,11 @@ CirMgr::printFloatGates() const
   _floatList.clear();
 
   for(size_t count = 1; count <= _size; ++count){
-    if(_gateList[count] == 0 || _gateList[count] -> getTypeStr() == "UNDEF") continue;
-    if((_gateList[count] -> getFanOutList()).empty() && _gateList[count] -> getTypeStr() != "PO")
+    if(!_gates.exists(count) || _gates.isUndef(count)) continue;
+    if(!_gates.hasFanOut(count) && !_gates.isPo(count))
       _unusedList.insert(count);
-    for(vector<AigGateV>::const_iterator it = (_gateList[count] -> getFanInList()).begin(); it != (_gateList[count] -> getFanInList()).end(); ++it){
-      if((*it).gate() -> getTypeStr() == "UNDEF"){
+    for(unsigned i = 0; i < _gates.fanInNum(count); ++i){
+      if(_gates.isUndef(_gates.getFanInId(count,i))){
         _floatList.insert(count);
         break;
       }
@@ -397,6 +702,15 @@ CirMgr::printFloatGates() const
   }  
 }
 
+CirMgr::IdList
+CirMgr::getFEClist(unsigned id) const
+{
+  IdList list;
+  for(unsigned i = _fecGrps[id].first; i < _fecGrps[id].second; ++i)
+    if(_fecId[_fecMember[i]] == (int)id) list.push_back(_fecMember[i]);
+  return list;
+}
+
 void
 CirMgr::printFECPairs() const
 {
@@ -410,8 +724,8 @@ CirMgr::printFECPairs() const
   unsigned current = 0;
 
   for(unsigned i = 0; i <= _size; ++i){
-    if(!_gateList[i]) continue;
-    const int& id = _gateList[i] -> getFec();
+    if(!_gates.exists(i)) continue;
+    const int& id = _fecId[i];
     if(id == -1) continue;
     if(fecList[id] == -1){
       fecList[id] = current;
@@ -427,7 +741,7 @@ CirMgr::printFECPairs() const
     cout << "[" << i << "]";
     for(unsigned j = 0; j < list[i].size(); ++j){
       cout << " ";
-      if(_gateList[list[i][j]] -> getPattern() == ~(_gateList[list[i][0]]) -> getPattern())
+      if(getSimValue(list[i][j]) == ~getSimValue(list[i][0]))
         cout << "!";
       cout << list[i][j];
     }
@@ -450,186 +764,192 @@ CirMgr::writeAag(ostream& outfile) const
     outfile << _PIList[count] * 2 << endl;
   }
   for(size_t count = 0; count < _POsize; ++count){
-    outfile << ((POGate*)_gateList[_POList[count]]) -> getInfo() << endl;
+    outfile << _gates.getFanIn(_POList[count],0) << endl;
   }
   for(vector<int>::iterator it = aigList.begin(); it != aigList.end();){
     outfile << *it; ++it; outfile << " "; outfile << *it; ++it; outfile << " "; outfile << *it; ++it; outfile << endl;
   }
   for(size_t count = 0; count < _PIsize; ++count){
-    if(_gateList[_PIList[count]] -> getName() != "")
-      outfile << "i" << count << " " << _gateList[_PIList[count]] -> getName() << endl;
+    if(getName(_PIList[count]) != "")
+      outfile << "i" << count << " " << getName(_PIList[count]) << endl;
   }
   for(size_t count = 0; count < _POsize; ++count){
-    if(_gateList[_POList[count]] -> getName() != "")
-      outfile << "o" << count << " " << _gateList[_POList[count]] -> getName() << endl;
+    if(getName(_POList[count]) != "")
+      outfile << "o" << count << " " << getName(_POList[count]) << endl;
   }
   outfile << "c" << endl;
   outfile << "AAG output by Chien-You (Benny) Huang" << endl;  
 }
 
+// Binary AIGER requires PIs to be 1..I and AIGs I+1..I+A in topological
+// order, so the gates are renumbered on the way out. Floating fanins are
+// written as constant 0, the value fraig assumes for UNDEF gates.
 void
-CirMgr::writeGate(ostream& outfile, CirGate *g) const
+CirMgr::writeAig(ostream& outfile) const
 {
-  /*
-  CirGate::IncGlobalRef();
-  dfs(g);
-  unsigned info[5]; //M I L O A
-  for(unsigned i = 0; i < 5; ++i)
-    info[i] = 0;
-  for(unsigned i = 0; i < _dfsList.size(); ++i){
-    if(_dfsList[i] -> getTypeStr() == "AIG") info[4]++;
-    if(_dfsList[i] -> getTypeStr() == "PI") info[1]++;
+  vector<int> aigList = getAigList();
+  size_t aigNum = aigList.size()/3;
+  vector<unsigned> newId(_size + 1,0);
+  for(size_t count = 0; count < _PIsize; ++count)
+    newId[_PIList[count]] = count + 1;
+  for(size_t count = 0; count < aigNum; ++count)
+    newId[aigList[3*count]/2] = _PIsize + count + 1;
+
+  outfile << "aig " << _PIsize + aigNum << " " << _PIsize << " 0 "
+          << _POsize << " " << aigNum << endl;
+  for(size_t count = 0; count < _POsize; ++count){
+    size_t lit = _gates.getFanIn(_POList[count],0);
+    outfile << 2*newId[lit/2] + lit%2 << endl;
   }
+  for(size_t count = 0; count < aigNum; ++count){
+    unsigned lhs = 2*(_PIsize + count + 1);
+    unsigned rhs0 = 2*newId[aigList[3*count + 1]/2] + aigList[3*count + 1]%2;
+    unsigned rhs1 = 2*newId[aigList[3*count + 2]/2] + aigList[3*count + 2]%2;
+    if(rhs0 < rhs1) swap(rhs0,rhs1);
+    writeDelta(outfile,lhs - rhs0);
+    writeDelta(outfile,rhs0 - rhs1);
+  }
+  for(size_t count = 0; count < _PIsize; ++count){
+    if(getName(_PIList[count]) != "")
+      outfile << "i" << count << " " << getName(_PIList[count]) << endl;
+  }
+  for(size_t count = 0; count < _POsize; ++count){
+    if(getName(_POList[count]) != "")
+      outfile << "o" << count << " " << getName(_POList[count]) << endl;
+  }
+  outfile << "c" << endl;
+  outfile << "AIG output by Chien-You (Benny) Huang" << endl;
+}
 
-
-
-  updateDfsList();
-  */
-  vector<CirGate*> list;
+void
+CirMgr::writeGate(ostream& outfile, unsigned g) const
+{
+  IdList list;
   unsigned info[5];
-  CirGate::IncGlobalRef();
-  gateDfs(g,list);
+  _gates.newMark();
+  dfs(g,list);
   for(unsigned i = 0; i < 5; ++i)
     info[i] = 0;
   info[3] = 1;
   for(unsigned i = 0; i < list.size(); ++i){
-    if(info[0] < list[i] -> getGateID() && list[i] -> getTypeStr() != "UNDEF") //M
-      info[0] = list[i] -> getGateID();
-    if(list[i] -> getTypeStr() == "PI") //I
+    if(info[0] < list[i] && !_gates.isUndef(list[i])) //M
+      info[0] = list[i];
+    if(_gates.isPi(list[i])) //I
       ++info[1];
-    if(list[i] -> getTypeStr() == "AIG") //A
+    if(_gates.isAig(list[i])) //A
       ++info[4];
   }
 
   outfile << "aag" << " ";
   outfile << info[0] << " " << info[1] << " " << info[2] << " " << info[3] << " " << info[4] << endl;
   for(unsigned i = 0; i < _PIsize; ++i){ //Inputs
-    if(_gateList[_PIList[i]] -> getRef() == CirGate::getGlobalRef()){
+    if(_gates.isMarked(_PIList[i])){
       outfile << 2*_PIList[i] << endl;
     }
   }
-  outfile << 2*(g -> getGateID()) << endl; //Output (single)
+  outfile << 2*g << endl; //Output (single)
 
   for(unsigned i = 0; i < list.size(); ++i){
-    if(list[i] -> getTypeStr() == "PI" || list[i] -> getTypeStr() == "UNDEF") continue;
-    if(list[i] -> getTypeStr() == "CONST") continue;
+    if(!_gates.isAig(list[i])) continue;
     //if(list[i] == g) continue;
-    size_t in1 = 2*((list[i] -> getFanInList())[0].gate() -> getGateID());
-    size_t in2 = 2*((list[i] -> getFanInList())[1].gate() -> getGateID());
-    if((list[i] -> getFanInList())[0].isInv()) ++in1;
-    if((list[i] -> getFanInList())[1].isInv()) ++in2;
-    outfile << 2*(list[i] -> getGateID()) << " " << in1 << " " << in2 << endl;
+    outfile << 2*list[i] << " " << _gates.getFanIn(list[i],0) << " " << _gates.getFanIn(list[i],1) << endl;
   }
 
   unsigned num = 0;
   for(unsigned i = 0; i < _PIsize; ++i){
-    if(_gateList[_PIList[i]] -> getRef() == CirGate::getGlobalRef()){
-      if(_gateList[_PIList[i]] -> getName() != ""){
-        outfile << "i" << num << " " << _gateList[_PIList[i]] -> getName() << endl;
+    if(_gates.isMarked(_PIList[i])){
+      if(getName(_PIList[i]) != ""){
+        outfile << "i" << num << " " << getName(_PIList[i]) << endl;
       }
       ++num;
     }
   }
 
-  outfile << "o0" << " " << g -> getGateID() << endl;
+  outfile << "o0" << " " << g << endl;
 
   outfile << "c" << endl;
 
-  outfile << "Write gate (" << g -> getGateID() << ") " << "by Chien-You (Benny) Huang" << endl;
+  outfile << "Write gate (" << g << ") " << "by Chien-You (Benny) Huang" << endl;
 
 }
 
 vector<int>
 CirMgr::getAigList() const
 {
-  CirGate::IncGlobalRef();
+  IdList order;
+  _gates.newMark();
+  for(size_t count = 0; count < _POsize; ++count)
+    dfs(_POList[count],order);
   vector<int> list;
-  for(size_t count = 0; count < _POsize; ++count){
-    _gateList[_POList[count]] -> setRef(CirGate::getGlobalRef());
-    for(vector<AigGateV>::const_iterator it = (_gateList[_POList[count]] -> getFanInList()).begin(); it != (_gateList[_POList[count]] -> getFanInList()).end(); ++it){
-      traverseFanIn(*it,list);
-    }
+  for(size_t count = 0; count < order.size(); ++count){
+    unsigned g = order[count];
+    if(!_gates.isAig(g)) continue;
+    list.push_back(g*2);
+    list.push_back(_gates.getFanIn(g,0));
+    list.push_back(_gates.getFanIn(g,1));
   }
   return list;
 }
 
-void
-CirMgr::traverseFanIn(AigGateV ptr,vector<int>& list) const
-{
-  if(ptr.gate() -> getRef() == CirGate::getGlobalRef()) return;
-  if(ptr.gate() -> getTypeStr() != "AIG") return;
-  for(vector<AigGateV>::const_iterator it = (ptr.gate() -> getFanInList()).begin(); it != (ptr.gate() -> getFanInList()).end(); ++it){
-    traverseFanIn(*it,list);
-  }
-  list.push_back((ptr.gate() -> getGateID())*2);
-  list.push_back(((ptr.gate() -> getFanInList())[0].gate() -> getGateID())*2 + (ptr.gate() -> getFanInList())[0].isInv());
-  list.push_back(((ptr.gate() -> getFanInList())[1].gate() -> getGateID())*2 + (ptr.gate() -> getFanInList())[1].isInv());
-  ptr.gate() -> setRef(CirGate::getGlobalRef());
-  return;
-}
-
+// Rebuild _dfsList only if the netlist has been rewired since the last
+// traversal; passes that keep the order valid (sweep, strash) leave
+// _dfsValid set so that the next command reuses it.
 void
 CirMgr::updateDfsList()
 {
+  if(_dfsValid) return;
   _dfsList.clear();
-  CirGate::IncGlobalRef();
+  _gates.newMark();
   for(size_t count = 0; count < _POsize; ++count){
-    dfs(_gateList[_POList[count]]);
+    dfs(_POList[count],_dfsList);
   }
+  _dfsPos.assign(_size + 1,~0u);
+  for(size_t count = 0; count < _dfsList.size(); ++count)
+    _dfsPos[_dfsList[count]] = count;
+  _dfsValid = true;
+  _simOrderValid = false;
 }
 
+// Mark the gates in _dfsList with a new mark, as a fresh traversal
+// would have done
 void
-CirMgr::dfs(CirGate* g)
+CirMgr::markDfsList() const
 {
-  if(g -> getRef() == CirGate::getGlobalRef()) return;
-  g -> setRef(CirGate::getGlobalRef());
-  for(vector<AigGateV>::iterator it = (g -> getFanInList()).begin(); it != (g -> getFanInList()).end(); ++it){
-    dfs((*it).gate());
-  }
-  _dfsList.push_back(g);
+  _gates.newMark();
+  for(size_t count = 0; count < _dfsList.size(); ++count)
+    _gates.mark(_dfsList[count]);
 }
 
+// Topological (post-order) DFS from "g" with an explicit stack, so deep
+// netlists cannot overflow the call stack. Gates already marked since the
+// last newMark() are skipped; fanins are visited in order, which gives
+// the same order as a recursive traversal.
 void
-CirMgr::gateDfs(CirGate* g,vector<CirGate*>& list) const {
-  if(g -> getRef() == CirGate::getGlobalRef()) return;
-  g -> setRef(CirGate::getGlobalRef());
-  for(vector<AigGateV>::iterator it = (g -> getFanInList()).begin(); it != (g -> getFanInList()).end(); ++it){
-    gateDfs((*it).gate(),list);
-  }
-  list.push_back(g);
-}
-
-bool
-CirMgr::lexOptions
-(const string& option, vector<string>& tokens, size_t nOpts) const
+CirMgr::dfs(unsigned g,IdList& list) const
 {
-   string token;
-   size_t n = myStrGetTok(option, token);
-   while (token.size()) {
-      tokens.push_back(token);
-      n = myStrGetTok(option, token, n);
-   }
-   if (nOpts != 0) {
-      if (tokens.size() < nOpts) {
-         return false;
-      }
-      if (tokens.size() > nOpts) {
-         return false;
-      }
-   }
-   return true;
+  if(_gates.isMarked(g)) return;
+  _gates.mark(g);
+  _dfsStack.clear();
+  _dfsStack.push_back(make_pair(g,0u));
+  while(!_dfsStack.empty()){
+    unsigned top = _dfsStack.back().first;
+    unsigned next = _dfsStack.back().second++;
+    if(next < _gates.fanInNum(top)){
+      unsigned in = _gates.getFanInId(top,next);
+      if(_gates.isMarked(in)) continue;
+      _gates.mark(in);
+      _dfsStack.push_back(make_pair(in,0u));
+    }
+    else{
+      list.push_back(top);
+      _dfsStack.pop_back();
+    }
+  }
 }
 
 void
 CirMgr::reset(){
-  if(_gateList){
-    for(unsigned i = 0; i <= _size; ++i){
-      if(_gateList[i])
-        delete _gateList[i];
-    }
-    delete[] _gateList;
-  }
-  if(_PIList) delete _PIList;
-  if(_POList) delete _POList;
-  if(_AIGList) delete _AIGList;
-}
\ No newline at end of file
+  _gates.clear();
+  _PIList.clear();
+  _POList.clear();
+}
@@ -15,7 +15,13 @@
 #include <iostream>
 #include <set>
 #include <map>
+#include <ctime>
+#include <mutex>
+#include <condition_variable>
 #include "cirGate.h"
+#include "rnGen.h"
+#include "sat.h"
+#include "aigSat.h"
 
 using namespace std;
 
@@ -28,33 +34,74 @@ extern CirMgr *cirMgr;
 class CirMgr
 {
 typedef vector<unsigned> IdList;
+// A SAT solver and the cones loaded into it so far; fraig keeps one per
+// thread.  With "circuit" the cones go to "aigSolver" as gates, otherwise
+// to "solver" as CNF.
+struct ProofModel {
+   ProofModel(): circuit(false), retired(0) {}
+   void setBudget(int64 conflicts) {
+      solver.setBudget(conflicts,-1); aigSolver.setBudget(conflicts,-1);
+   }
+   SatSolver solver;
+   AigSolver aigSolver;
+   bool circuit;
+   vector<Var> satVar; // SAT variable of gate i, 0 if not loaded
+   unsigned retired; // retired miter activation variables in the solver
+   vector<pair<unsigned,unsigned>> stack; // loadCone() scratch
+};
+// A candidate pair of a parallel fraig round and its outcome
+struct FraigTask {
+   unsigned rep, id, grp;
+   bool inv;
+   int result; // 1/0/-1 for SAT/UNSAT/undecided, -2 if not tried
+   vector<size_t> model; // PI values of the SAT model, packed
+};
+// The worker threads of randomSim() wait here between rounds; "round"
+// counts the rounds started, "busy" the workers still on this one
+struct SimPool {
+   SimPool(): round(0), busy(0), stop(false) {}
+   mutex m;
+   condition_variable go, done;
+   unsigned round, busy;
+   bool stop;
+};
 public:
-   CirMgr() : _gateList(0), _PIList(0), _POList(0), _AIGList(0), _size(0), _PIsize(0), _POsize(0), _AIGsize(0), _fecInit(false) {}
+   CirMgr() : _size(0), _PIsize(0), _POsize(0), _AIGsize(0), _fecInit(false), _dfsValid(false), _simOrderValid(false), _quiet(false), _simLog(0), _cexNum(0), _simWords(SIM_WORDS), _simBlocks(1), _simSeed(0) {}
    ~CirMgr() { reset(); } 
 
    // Access functions
-   // return '0' if "gid" corresponds to an undefined gate.
-   CirGate* getGate(unsigned gid) const { if(gid > _size) return 0; return _gateList[gid]; }
-   static CirGate* readAigGateV(const AigGateV& ptr) { return ptr.gate(); }
-   const vector<unsigned>& getFEClist(const unsigned& id) const { return *(_fecGrps[id]); }
+   // return false if "gid" corresponds to an undefined gate.
+   bool isGate(unsigned gid) const { return _gates.exists(gid); }
+   bool isAig(unsigned gid) const { return _gates.exists(gid) && _gates.isAig(gid); }
+   IdList getFEClist(unsigned id) const;
    unsigned getFECsize() const { return _fecGrps.size(); }
 
+   // Per-gate attributes, indexed by gate id
+   const string& getName(unsigned gid) const;
+   // first word of the signature; enough to tell a gate from its complement
+   size_t getSimValue(unsigned gid) const { return _simValue[gid*_simWords]; }
+   int getFecId(unsigned gid) const { return _fecId[gid]; }
+
    // Member functions about circuit construction
    bool readCircuit(const string&);
+   bool readMiter(const string&,const string&);
 
    // Member functions about circuit optimization
    void sweep();
    void optimize();
 
    // Member functions about simulation
-   void randomSim();
+   void randomSim(unsigned threads = 1);
    void fileSim(ifstream&);
    void setSimLog(ofstream *logFile) { _simLog = logFile; }
+   void setSimWidth(unsigned);
+   void setSimSeed(size_t);
 
    // Member functions about fraig
-   void strash();
    void printFEC() const;
-   void fraig();
+   void fraig(unsigned conflictLimit = FRAIG_CONFLICTS, unsigned timeLimit = 0,
+              unsigned threads = 1, bool circuit = false);
+   void cec();
 
    // Member functions about circuit reporting
    void printSummary() const;
@@ -64,44 +111,107 @@ public:
    void printFloatGates() const;
    void printFECPairs() const;
    void writeAag(ostream&) const;
-   void writeGate(ostream&, CirGate*) const;
+   void writeAig(ostream&) const;
+   void writeGate(ostream&, unsigned) const;
+
+   // Member functions about gate reporting
+   void reportGate(unsigned) const;
+   void reportFanin(unsigned,int) const;
+   void reportFanout(unsigned,int) const;
 
 private:
-   bool lexOptions(const string&, vector<string>&, size_t nOpts = 0) const;
-   void printNetlist(AigGateV,int&) const;
+   bool parseAag();
+   void printGate(unsigned) const;
+   void reportFanin(int,int,unsigned) const;
+   void reportFanout(int,int,unsigned) const;
+   vector<unsigned> sortedFanOut(unsigned) const;
+   string getSimValueStr(unsigned) const;
+   string getFECpair(unsigned) const;
    vector<int> getAigList() const;
-   void traverseFanIn(AigGateV,vector<int>&) const;
    void updateDfsList();
-   void dfs(CirGate*);
-   void gateDfs(CirGate*,vector<CirGate*>&) const;
-   void optSameFanIn(CirGate*,bool);
-   void optConstFanIn(CirGate*,bool);
+   void markDfsList() const;
+   void dfs(unsigned,IdList&) const;
+   void optSameFanIn(unsigned,bool);
+   void optConstFanIn(unsigned,bool);
    void sim(unsigned);
+   void simRandomBlock(unsigned);
+   void simWorker(SimPool&,unsigned);
+   void writeSimLog(unsigned,unsigned) const;
+   void setSimBlocks(unsigned);
+   void buildSimOrder();
    void resetPattern();
    void initFEC();
    void chkFEC();
    void resetFecGrps();
-   void genProofModel(SatSolver*&);
-   unsigned proveFEC(SatSolver*&,CirGate*&,vector<pair<CirGate*,unsigned>>&);
-   void merge(vector<pair<CirGate*,unsigned>>&);
-   static bool sortFanOut(AigGateV p1,AigGateV p2) { return (p1.gate() -> getGateID() < p2.gate() -> getGateID()); }
+   void genProofModel(ProofModel&) const;
+   void loadCone(ProofModel&,unsigned) const;
+   template<class S> void loadCone(ProofModel&,S&,unsigned) const;
+   unsigned fecRep(unsigned);
+   int provePair(ProofModel&,unsigned,unsigned,bool) const;
+   template<class S> int provePair(ProofModel&,S&,unsigned,unsigned,bool) const;
+   int proveFEC(ProofModel&,unsigned,vector<pair<unsigned,unsigned>>&);
+   bool proveRound(vector<ProofModel>&,const vector<unsigned>&,vector<pair<unsigned,unsigned>>&,unsigned&,unsigned&,time_t,unsigned);
+   void proveTasks(ProofModel&,const vector<unsigned>&,vector<FraigTask>&,time_t,unsigned) const;
+   void getModel(const ProofModel&,vector<size_t>&) const;
+   template<class S> void getModel(const ProofModel&,const S&,vector<size_t>&) const;
+   void addCex(const vector<size_t>&);
+   void simCex();
+   void merge(vector<pair<unsigned,unsigned>>&);
+   bool unhash(unsigned);
+   void unhashFanOut(unsigned,vector<unsigned>&);
+   void rehash(vector<unsigned>&);
    void reset();
 
-   CirGate** _gateList;
-   size_t* _PIList;
-   size_t* _POList;
-   size_t* _AIGList;
+   IdList _PIList;
+   IdList _POList;
    unsigned _size;
    size_t _PIsize;
    size_t _POsize;
    size_t _AIGsize;
    bool _fecInit;
+   bool _dfsValid; // _dfsList matches the netlist; cleared on rewiring
+   bool _simOrderValid; // _simGate/_simIn0/_simIn1 match _dfsList
+   // _strash maps the fanin literals of every AIG to its id, so no two
+   // AIGs have the same fanins; readCircuit() builds it and every pass
+   // that rewires the netlist keeps it up to date
+   StrashTable _strash;
+   bool _quiet; // no per-merge reports, set by cec()
    vector<int> headerInfo; //M I L O A
    mutable set<size_t> _floatList; //gates with floating fanin(s)
    mutable set<size_t> _unusedList; //gates defined but not used
-   mutable vector<CirGate*> _dfsList;
-   mutable vector<IdList*> _fecGrps;
+   mutable IdList _dfsList;
+   vector<unsigned> _dfsPos; // index of each gate in _dfsList, ~0u if not in
+   mutable vector<pair<unsigned,unsigned>> _dfsStack; // for dfs()
+   // FEC group i is the members of _fecMember[_fecGrps[i].first,
+   // _fecGrps[i].second) whose _fecId is still i
+   vector<unsigned> _fecMember;
+   vector<pair<unsigned,unsigned>> _fecGrps;
+   vector<pair<unsigned,unsigned>> _fecNewGrps; // chkFEC() scratch
+   vector<pair<size_t,size_t>> _fecSort; // chkFEC() scratch: (hash, pos|gid)
    ofstream           *_simLog;
+   // SAT counterexamples of fraig; bit k of PI i's block is the k-th one
+   vector<size_t> _cexPattern;
+   unsigned _cexNum;
+   vector<pair<unsigned,unsigned>> _cexPair; // (candidate, representative)
+   vector<size_t> _cexModel; // proveFEC() scratch
+
+   // Gate attributes stored per attribute, indexed by gate id
+   CirGateStore _gates; // type, line, fanins and fanouts
+   unsigned _simWords; // words per signature block, i.e. patterns / 64
+   unsigned _simBlocks; // pattern blocks of the last pass, one per thread
+   // random pattern stream of block b, seeded with _simSeed + b; the
+   // streams go on from one randomSim() to the next
+   vector<PatternGen> _simGen;
+   size_t _simSeed;
+   // signature of gate i in block b at [(b*(_size+1) + i)*_simWords]
+   vector<size_t> _simValue;
+   vector<int> _fecId; // FEC group, -1 if the gate is in none
+   map<unsigned,string> _nameList; // sparse: only PIs/POs may have names
+   // AIGs/POs of _dfsList as literals (2*id+inv), in topological order;
+   // a PO is an AND of its fanin with itself
+   vector<unsigned> _simGate;
+   vector<unsigned> _simIn0;
+   vector<unsigned> _simIn1;
 
 };
 
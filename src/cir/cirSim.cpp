@@ -16,8 +16,9 @@
 #include "util.h"
 #include <climits>
 #include <sstream>
-#include <bitset>
 #include <ctime>
+#include <thread>
+#include "cirSimd.h"
 
 using namespace std;
 
@@ -31,40 +32,86 @@ using namespace std;
 /**************************************/
 /*   Static varaibles and functions   */
 /**************************************/
+// Key of a signature made of "blocks" blocks of "words" words, "stride"
+// words apart; a signature and its complement hash to the same key so
+// that inverted FEC candidates share a group
 class SimValue
 {
 public:
-	SimValue(size_t& val): _simValue(val) {}
-	size_t operator() () const { if(_simValue < ~_simValue) return _simValue; else return ~_simValue; }
-	bool operator== (const SimValue& k) const { return ((_simValue == k._simValue) || (_simValue == ~(k._simValue))); }
+	SimValue(const size_t* val, unsigned words, unsigned blocks, size_t stride):
+		_simValue(val), _words(words), _blocks(blocks), _stride(stride) {}
+	size_t operator() () const {
+		size_t mask = (_simValue[0] < ~_simValue[0])? 0 : ~size_t(0);
+		size_t h = 0;
+		for(unsigned b = 0; b < _blocks; ++b){
+			const size_t* val = _simValue + b*_stride;
+			for(unsigned i = 0; i < _words; ++i)
+				h = (h ^ (val[i] ^ mask)) * 0x100000001b3ULL;
+		}
+		return h;
+	}
+	bool operator== (const SimValue& k) const {
+		size_t mask = (_simValue[0] == k._simValue[0])? 0 : ~size_t(0);
+		for(unsigned b = 0; b < _blocks; ++b){
+			const size_t* v1 = _simValue + b*_stride;
+			const size_t* v2 = k._simValue + b*_stride;
+			for(unsigned i = 0; i < _words; ++i)
+				if(v1[i] != (v2[i] ^ mask)) return false;
+		}
+		return true;
+	}
 private:
-	size_t _simValue;
+	const size_t* _simValue;
+	unsigned _words;
+	unsigned _blocks;
+	size_t _stride;
 };
 
 /************************************************/
 /*   Public member functions about Simulation   */
 /************************************************/
+// With "threads" > 1 every thread simulates its own block of patterns
+// over the shared sim order; chkFEC() then refines on all blocks at once.
+// The threads stay up for the whole run, and the stop rule counts
+// patterns, so more threads simulate the same amount in fewer rounds.
 void
-CirMgr::randomSim()
+CirMgr::randomSim(unsigned threads)
 {
 	updateDfsList();
+	buildSimOrder();
 	if(!_fecInit) { initFEC(); _fecInit = true; }
+	setSimBlocks(threads);
 	resetPattern();
-	unsigned count = 0;
-	unsigned fail = 0;
-	unsigned wanted = 160;
-	clock_t start,stop;
-	start = clock();
-	while(fail < wanted){
-		++count;
-		for(unsigned i = 0; i < _PIsize; ++i){
-			size_t pattern = 0;
-			pattern = rnGen(INT_MAX);
-			pattern = pattern << (size_t)32;
-			pattern = pattern | rnGen(INT_MAX);
-			_gateList[_PIList[i]] -> setPattern(pattern);
+	while(_simGen.size() < threads)
+		_simGen.push_back(PatternGen(_simSeed + _simGen.size()));
+	const size_t block = 64*_simWords;
+	const size_t width = block*threads;
+	// stop once the FEC groups have hardly changed (by less than 5 per
+	// round) for "patience" patterns, counted after the first "warmup"
+	const size_t warmup = 320*block, patience = 160*block;
+	size_t patterns = 0, stable = 0;
+	time_t start = time(0);
+	SimPool pool;
+	vector<thread> workers;
+	for(unsigned t = 1; t < threads; ++t)
+		workers.push_back(thread(&CirMgr::simWorker, this, ref(pool), t));
+	while(stable < patience){
+		{
+			lock_guard<mutex> lock(pool.m);
+			++pool.round;
+			pool.busy = threads - 1;
+		}
+		pool.go.notify_all();
+		simRandomBlock(0);
+		{
+			unique_lock<mutex> lock(pool.m);
+			while(pool.busy) pool.done.wait(lock);
+		}
+		patterns += width;
+		if(_simLog){
+			for(unsigned t = 0; t < threads; ++t)
+				writeSimLog(t, block);
 		}
-		sim(64);
 		int old = _fecGrps.size();
 		chkFEC();
 		if(_fecGrps.size()){
@@ -72,13 +119,19 @@ CirMgr::randomSim()
 			cout << char(13) << setw(30) << ' ' << char(13);
 		}
 		if(_fecGrps.size() == 0) break;
-		stop = clock();
-		if((double)((stop-start)/CLOCKS_PER_SEC) > 15) break;
-		if(abs(old - _fecGrps.size()) < 5 && count > 320) fail++;
+		if(difftime(time(0),start) > 15) break;
+		if(abs(old - (int)_fecGrps.size()) < 5 && patterns > warmup) stable += width;
 		else
-			fail = 0;
+			stable = 0;
 	}
-	cout << (count*64) << " " << "patterns simulated." << endl;
+	{
+		lock_guard<mutex> lock(pool.m);
+		pool.stop = true;
+	}
+	pool.go.notify_all();
+	for(unsigned t = 0; t < workers.size(); ++t)
+		workers[t].join();
+	cout << patterns << " " << "patterns simulated." << endl;
 
 }
 
@@ -87,20 +140,24 @@ CirMgr::fileSim(ifstream& patternFile)
 {
 	string str;
 	updateDfsList();
+	buildSimOrder();
 
 	if(!_fecInit){ initFEC(); }
+	setSimBlocks(1);
 
 	for(unsigned i = 0; i < _PIsize; ++i){
-		_gateList[_PIList[i]] -> resetPattern();
+		for(unsigned w = 0; w < _simWords; ++w)
+			_simValue[_PIList[i]*_simWords + w] = 0;
 	}
 
+	const unsigned width = 64*_simWords;
 	unsigned count = 0;
 
 	while(patternFile >> str){
 		//patternFile >> str;
 		if(str.empty()) continue;
 		++count;
-		if(count%64 == 1) resetPattern();
+		if(count%width == 1) resetPattern();
 		if(str.length() != _PIsize){
 			cerr << "Error: Pattern(" << str << ") length(" << str.length() << ") does not match the number of inputs(" << _PIsize << ") in a circuit!!" << endl;
 			resetPattern();
@@ -108,6 +165,7 @@ CirMgr::fileSim(ifstream& patternFile)
 				resetFecGrps();
 			return;
 		}
+		const unsigned bit = (count-1)%width;
 		for(unsigned i = 0; i < _PIsize; ++i){
 			if(str[i] != '0' && str[i] != '1'){
 				cerr << "Error: Pattern(" << str << ") contains a non-0/1 character('" << str[i] << "')." << endl;
@@ -118,11 +176,12 @@ CirMgr::fileSim(ifstream& patternFile)
 			}
 			size_t p = 0;
 			if(str[i] == '1') p = (size_t)1;
-			p = p << (size_t)((count-1)%64);
-			_gateList[_PIList[i]] -> getPattern() = _gateList[_PIList[i]] -> getPattern() | p;
+			p = p << (size_t)(bit%64);
+			_simValue[_PIList[i]*_simWords + bit/64] |= p;
 		}
-		if(count%64 == 0){
-			sim(64);
+		if(count%width == 0){
+			sim(0);
+			writeSimLog(0, width);
 			chkFEC();
 			if(_fecGrps.size()){
 				cout << "Total #FEC Group = " << _fecGrps.size() << flush;
@@ -130,8 +189,9 @@ CirMgr::fileSim(ifstream& patternFile)
 			}
 		}
 	}
-	if(count%64 != 0){
-		sim(count%64);
+	if(count%width != 0){
+		sim(0);
+		writeSimLog(0, count%width);
 		chkFEC();
 		if(_fecGrps.size()){
 			cout << "Total #FEC Group = " << _fecGrps.size() << flush;
@@ -146,118 +206,205 @@ CirMgr::fileSim(ifstream& patternFile)
 	cout << count << " " << "patterns simulated." << endl;
 }
 
+void
+CirMgr::setSimWidth(unsigned bits)
+{
+	assert(bits && bits%64 == 0);
+	_simWords = bits/64;
+	_simValue.assign((_size + 1)*_simWords*_simBlocks,0);
+}
+
+// Restart the pattern stream of every block from "seed"
+void
+CirMgr::setSimSeed(size_t seed)
+{
+	_simSeed = seed;
+	_simGen.clear();
+}
+
 /*************************************************/
 /*   Private member functions about Simulation   */
 /*************************************************/
+// Evaluate the sim order on pattern block "block"; blocks are disjoint,
+// so several threads may run this at once
 void
-CirMgr::sim(unsigned size){
-	for(unsigned i = 0; i < _dfsList.size(); ++i){
-		_dfsList[i] -> simulation();
-	}
-	if(_simLog){
-		bitset<64>* _inList = new bitset<64>[_PIsize];
-		bitset<64>* _outList = new bitset<64>[_POsize];
-		for(unsigned i = 0; i < _PIsize; ++i){
-			_inList[i] = bitset<64>(_gateList[_PIList[i]] -> getPattern());
+CirMgr::sim(unsigned block){
+	const unsigned words = _simWords;
+	size_t* val = &_simValue[(size_t)block*(_size + 1)*words];
+	// the widest kernel this CPU runs, whatever the build flags are
+	static const SimGatesFunc simGates = simGatesFunc(simBestIsa());
+	simGates(val, _simGate.data(), _simIn0.data(), _simIn1.data(), _simGate.size(), words);
+}
+
+// Fill the PIs of pattern block "block" from its own stream and simulate
+// the block; blocks are disjoint, so several threads may run this at once
+void
+CirMgr::simRandomBlock(unsigned block)
+{
+	size_t* val = &_simValue[(size_t)block*(_size + 1)*_simWords];
+	for(unsigned i = 0; i < _PIsize; ++i)
+		_simGen[block].fill(val + _PIList[i]*_simWords,_simWords);
+	sim(block);
+}
+
+// Thread body of randomSim(): simulate block "block" once per round
+// until the pool is stopped
+void
+CirMgr::simWorker(SimPool& pool,unsigned block)
+{
+	unsigned seen = 0;
+	while(true){
+		{
+			unique_lock<mutex> lock(pool.m);
+			while(!pool.stop && pool.round == seen) pool.go.wait(lock);
+			if(pool.stop) return;
+			seen = pool.round;
 		}
-		for(unsigned i = 0; i < _POsize; ++i){
-			_outList[i] = bitset<64>(_gateList[_POList[i]] -> getPattern());
+		simRandomBlock(block);
+		lock_guard<mutex> lock(pool.m);
+		if(--pool.busy == 0) pool.done.notify_one();
+	}
+}
+
+// Log the first "size" patterns of pattern block "block"
+void
+CirMgr::writeSimLog(unsigned block, unsigned size) const
+{
+	if(!_simLog) return;
+	const unsigned words = _simWords;
+	const size_t* val = &_simValue[(size_t)block*(_size + 1)*words];
+	for(unsigned i = 0; i < size; ++i){
+		unsigned w = i/64, b = i%64;
+		for(unsigned j = 0; j < _PIsize; ++j){
+			(*_simLog) << ((val[_PIList[j]*words + w] >> b) & 1);
 		}
-		for(unsigned i = 0; i < size; ++i){
-			for(unsigned j = 0; j < _PIsize; ++j){
-				(*_simLog) << _inList[j][i];
-			}
-			(*_simLog) << " ";
-			for(unsigned j = 0; j < _POsize; ++j){
-				(*_simLog) << _outList[j][i];
-			}
-			(*_simLog) << endl;
+		(*_simLog) << " ";
+		for(unsigned j = 0; j < _POsize; ++j){
+			(*_simLog) << ((val[_POList[j]*words + w] >> b) & 1);
 		}
-		delete[] _inList;
-		delete[] _outList;
+		(*_simLog) << endl;
 	}
 }
 
+void
+CirMgr::setSimBlocks(unsigned blocks)
+{
+	assert(blocks);
+	_simBlocks = blocks;
+	_simValue.resize((size_t)(_size + 1)*_simWords*_simBlocks,0);
+}
+
 void
 CirMgr::initFEC()
 {
 	updateDfsList();
-	IdList* _initList = new IdList;
-	_initList -> push_back(0);
+	markDfsList();
+	resetFecGrps();
+	_fecMember.push_back(0);
 	for(unsigned i = 0; i < _dfsList.size(); ++i){
-		if(_dfsList[i] -> getTypeStr() != "AIG") continue;
-		_initList -> push_back(_dfsList[i] -> getGateID());
-		_dfsList[i] -> setFecId(1);
+		if(!_gates.isAig(_dfsList[i])) continue;
+		_fecMember.push_back(_dfsList[i]);
+		_fecId[_dfsList[i]] = 0;
 	}
-	_fecGrps.push_back(_initList);
+	_fecGrps.push_back(make_pair(0u,(unsigned)_fecMember.size()));
 	for(unsigned i = 0; i <= _size; ++i){
-		if(!_gateList[i]) continue;
-		if(_gateList[i] -> getTypeStr() != "AIG") continue;
-		if(_gateList[i] -> getRef() != CirGate::getGlobalRef())
-			_gateList[i] -> setFecId(-1);
+		if(!_gates.exists(i)) continue;
+		if(!_gates.isAig(i)) continue;
+		if(!_gates.isMarked(i))
+			_fecId[i] = -1;
 	}
 
 }
 
+// Split every FEC group by the phase-normalized signature.  Members are
+// sorted by (signature hash, old position), so each new group keeps the
+// old member order; groups are rewritten in place in _fecMember.  Members
+// whose _fecId no longer names the group were dropped by fraig.
 void
 CirMgr::chkFEC()
 {
-	vector<IdList*> newGrps;
 	if(_fecGrps.empty()) return;
+	const size_t stride = (size_t)(_size + 1)*_simWords;
+	const size_t gidMask = 0xffffffffULL;
+	unsigned top = 0; // next free slot in _fecMember
+	_fecNewGrps.clear();
 	for(unsigned i = 0; i < _fecGrps.size(); ++i){ //for each fecGrp in fecGrps
-		HashMap<SimValue,IdList*> fecHash((_fecGrps[i] -> size()));
-		for(unsigned j = 0; j < _fecGrps[i] -> size(); ++j){ //for each gate in fecGrp
-			IdList* _list = 0;
-			if(!_gateList[(*(_fecGrps[i]))[j]]) continue;
-			size_t& _p = _gateList[(*(_fecGrps[i]))[j]] -> getPattern();
-			SimValue val(_p);
-			fecHash.query(val,_list);
-			if(_list){
-				_list -> push_back((*(_fecGrps[i]))[j]);
-			}
-			else{
-				_list = new IdList;
-				_list -> push_back((*(_fecGrps[i]))[j]);
-				fecHash.insert(val,_list);
-			}
+		_fecSort.clear();
+		for(unsigned j = _fecGrps[i].first; j < _fecGrps[i].second; ++j){
+			unsigned gid = _fecMember[j];
+			if(!_gates.exists(gid) || _fecId[gid] != (int)i) continue;
+			SimValue val(&_simValue[gid*_simWords],_simWords,_simBlocks,stride);
+			_fecSort.push_back(make_pair(val(),((size_t)j << 32) | gid));
 		}
-		//check groups in hash
-		size_t count = 0;
-		for(HashMap<SimValue,IdList*>::iterator it = fecHash.begin(); it != fecHash.end(); ++it){
-			count++;
-			if((*it).second -> size() > 1){
-				newGrps.push_back((*it).second);
-			}
-			else{
-				_gateList[*((*it).second -> begin())] -> setFecId(-1);
-				delete (*it).second;
+		sort(_fecSort.begin(),_fecSort.end());
+		for(size_t r = 0, n = _fecSort.size(); r < n;){
+			size_t e = r + 1;
+			while(e < n && _fecSort[e].first == _fecSort[r].first) ++e;
+			// [r,e) share a hash; split off the members equal to the first
+			// unclaimed one until the run is used up (one pass unless the
+			// hash collides)
+			for(size_t k = r; k < e; ++k){
+				if(_fecSort[k].second == ~size_t(0)) continue;
+				unsigned gid = _fecSort[k].second & gidMask;
+				SimValue val(&_simValue[gid*_simWords],_simWords,_simBlocks,stride);
+				unsigned begin = top;
+				_fecMember[top++] = gid;
+				for(size_t l = k + 1; l < e; ++l){
+					if(_fecSort[l].second == ~size_t(0)) continue;
+					unsigned gid2 = _fecSort[l].second & gidMask;
+					if(!(SimValue(&_simValue[gid2*_simWords],_simWords,_simBlocks,stride) == val)) continue;
+					_fecMember[top++] = gid2;
+					_fecSort[l].second = ~size_t(0);
+				}
+				if(top - begin > 1){
+					for(unsigned m = begin; m < top; ++m)
+						_fecId[_fecMember[m]] = _fecNewGrps.size();
+					_fecNewGrps.push_back(make_pair(begin,top));
+				}
+				else{
+					_fecId[gid] = -1;
+					top = begin;
+				}
 			}
+			r = e;
 		}
 	}
-	_fecGrps.swap(newGrps);
-	for(unsigned i = 0; i < _fecGrps.size(); ++i){
-		for(unsigned j = 0; j < _fecGrps[i] -> size(); ++j){
-			_gateList[(*_fecGrps[i])[j]] -> setFecId(i);
-		}
-	}
-	for(unsigned i = 0; i < newGrps.size(); ++i){
-		if(newGrps[i]) delete newGrps[i];
-	}
+	_fecMember.resize(top);
+	_fecGrps.swap(_fecNewGrps);
 }
 
 void
 CirMgr::resetFecGrps()
 {
-	for(unsigned i = 0; i < _fecGrps.size(); ++i){
-		if(_fecGrps[i]) delete _fecGrps[i];
-	}
+	_fecMember.clear();
 	_fecGrps.clear();
 }
 
 void
 CirMgr::resetPattern()
 {
-	for(unsigned i = 0; i <= _size; ++i){
-		if(_gateList[i]) _gateList[i] -> resetPattern();
+	_simValue.assign(_simValue.size(),0);
+}
+
+// Flatten the AIGs/POs of _dfsList into literal arrays so that sim() is a
+// linear scan without virtual calls or pointer chasing
+void
+CirMgr::buildSimOrder()
+{
+	if(_simOrderValid) return;
+	_simGate.clear();
+	_simIn0.clear();
+	_simIn1.clear();
+	for(unsigned i = 0; i < _dfsList.size(); ++i){
+		const unsigned gid = _dfsList[i];
+		if(_gates.fanInNum(gid) == 0) continue;
+		unsigned lit0 = _gates.getFanIn(gid,0);
+		unsigned lit1 = lit0;
+		if(_gates.fanInNum(gid) > 1)
+			lit1 = _gates.getFanIn(gid,1);
+		_simGate.push_back(gid);
+		_simIn0.push_back(lit0);
+		_simIn1.push_back(lit1);
 	}
+	_simOrderValid = true;
 }
\ No newline at end of file
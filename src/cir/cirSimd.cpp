@@ -0,0 +1,135 @@
+/****************************************************************************
+  FileName     [ cirSimd.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the word-parallel AND kernels of simulation ]
+  Author       [ Chien-You (Benny) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include "cirSimd.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SIM_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+// out = (a ^ ma) & (b ^ mb) over "words" words; ma/mb are 0 or ~0 and
+// carry the fanin inversions
+static inline void
+simAnd(size_t* out, const size_t* a, size_t ma, const size_t* b, size_t mb, unsigned words)
+{
+	for(unsigned i = 0; i < words; ++i)
+		out[i] = (a[i] ^ ma) & (b[i] ^ mb);
+}
+
+static void
+simGatesScalar(size_t* val, const unsigned* gate, const unsigned* in0,
+               const unsigned* in1, unsigned n, unsigned words)
+{
+	for(unsigned i = 0; i < n; ++i){
+		simAnd(val + (size_t)gate[i]*words,
+		       val + (size_t)(in0[i] >> 1)*words, size_t(0) - (in0[i] & 1),
+		       val + (size_t)(in1[i] >> 1)*words, size_t(0) - (in1[i] & 1), words);
+	}
+}
+
+#ifdef SIM_X86_DISPATCH
+// The vector kernels are compiled for their own target only, so the
+// package needs no -mavx2/-mavx512f; simGatesFunc() checks the CPU
+__attribute__((target("avx2"))) static inline void
+simAndAvx2(size_t* out, const size_t* a, size_t ma, const size_t* b, size_t mb, unsigned words)
+{
+	const __m256i va = _mm256_set1_epi64x((long long)ma);
+	const __m256i vb = _mm256_set1_epi64x((long long)mb);
+	unsigned i = 0;
+	for(; i + 4 <= words; i += 4){
+		__m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i)), va);
+		__m256i y = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(b + i)), vb);
+		_mm256_storeu_si256((__m256i*)(out + i), _mm256_and_si256(x, y));
+	}
+	for(; i < words; ++i)
+		out[i] = (a[i] ^ ma) & (b[i] ^ mb);
+}
+
+__attribute__((target("avx2"))) static void
+simGatesAvx2(size_t* val, const unsigned* gate, const unsigned* in0,
+             const unsigned* in1, unsigned n, unsigned words)
+{
+	for(unsigned i = 0; i < n; ++i){
+		simAndAvx2(val + (size_t)gate[i]*words,
+		           val + (size_t)(in0[i] >> 1)*words, size_t(0) - (in0[i] & 1),
+		           val + (size_t)(in1[i] >> 1)*words, size_t(0) - (in1[i] & 1), words);
+	}
+}
+
+// Full 8-word vectors first, the rest 4 words and then 1 word at a time
+__attribute__((target("avx512f,avx2"))) static inline void
+simAndAvx512(size_t* out, const size_t* a, size_t ma, const size_t* b, size_t mb, unsigned words)
+{
+	const __m512i va = _mm512_set1_epi64((long long)ma);
+	const __m512i vb = _mm512_set1_epi64((long long)mb);
+	unsigned i = 0;
+	for(; i + 8 <= words; i += 8){
+		__m512i x = _mm512_xor_si512(_mm512_loadu_si512((const void*)(a + i)), va);
+		__m512i y = _mm512_xor_si512(_mm512_loadu_si512((const void*)(b + i)), vb);
+		_mm512_storeu_si512((void*)(out + i), _mm512_and_si512(x, y));
+	}
+	if(i < words) simAndAvx2(out + i, a + i, ma, b + i, mb, words - i);
+}
+
+__attribute__((target("avx512f,avx2"))) static void
+simGatesAvx512(size_t* val, const unsigned* gate, const unsigned* in0,
+               const unsigned* in1, unsigned n, unsigned words)
+{
+	for(unsigned i = 0; i < n; ++i){
+		simAndAvx512(val + (size_t)gate[i]*words,
+		             val + (size_t)(in0[i] >> 1)*words, size_t(0) - (in0[i] & 1),
+		             val + (size_t)(in1[i] >> 1)*words, size_t(0) - (in1[i] & 1), words);
+	}
+}
+#endif // SIM_X86_DISPATCH
+
+/***************************************/
+/*   Global functions about SimGates   */
+/***************************************/
+SimGatesFunc
+simGatesFunc(SimIsa isa)
+{
+	switch(isa){
+		case SIM_SCALAR: return simGatesScalar;
+#ifdef SIM_X86_DISPATCH
+		case SIM_AVX2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2")? simGatesAvx2 : 0;
+		case SIM_AVX512:
+			__builtin_cpu_init();
+			return (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2"))?
+			       simGatesAvx512 : 0;
+#endif
+		default: return 0;
+	}
+}
+
+SimIsa
+simBestIsa()
+{
+	for(int isa = SIM_ISA_TOT - 1; isa > SIM_SCALAR; --isa)
+		if(simGatesFunc(SimIsa(isa))) return SimIsa(isa);
+	return SIM_SCALAR;
+}
+
+const char*
+simIsaStr(SimIsa isa)
+{
+	switch(isa){
+		case SIM_SCALAR: return "scalar";
+		case SIM_AVX2:   return "AVX2";
+		case SIM_AVX512: return "AVX-512";
+		default:         return "?";
+	}
+}
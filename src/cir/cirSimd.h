@@ -0,0 +1,37 @@
+/****************************************************************************
+  FileName     [ cirSimd.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the word-parallel AND kernels of simulation ]
+  Author       [ Chien-You (Benny) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_SIMD_H
+#define CIR_SIMD_H
+
+#include <cstddef>
+
+// Instruction sets the simulation kernels are built for; the vector ones
+// only on x86-64 with GCC/Clang, whatever -march the package is built with
+enum SimIsa
+{
+   SIM_SCALAR = 0,
+   SIM_AVX2,
+   SIM_AVX512,
+
+   SIM_ISA_TOT
+};
+
+// Simulate "n" AIGs in order over "words" words per gate: gate[i] gets
+// the AND of the values of the fanin literals in0[i] and in1[i]
+typedef void (*SimGatesFunc)(size_t* val, const unsigned* gate,
+                             const unsigned* in0, const unsigned* in1,
+                             unsigned n, unsigned words);
+
+// The kernel for "isa", or 0 if it is not built or the CPU lacks it
+SimGatesFunc simGatesFunc(SimIsa isa);
+// The widest kernel the CPU runs
+SimIsa simBestIsa();
+const char* simIsaStr(SimIsa isa);
+
+#endif // CIR_SIMD_H
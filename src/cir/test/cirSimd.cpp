@@ -0,0 +1 @@
+../cirSimd.cpp
\ No newline at end of file
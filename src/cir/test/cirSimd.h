@@ -0,0 +1 @@
+../cirSimd.h
\ No newline at end of file
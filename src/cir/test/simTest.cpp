@@ -0,0 +1,71 @@
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include "cirSimd.h"
+
+using namespace std;
+
+// Random AIGs over "piNum" PIs (ids 1..piNum, 0 is the constant); every
+// AIG reads two literals of smaller ids, so the list is a valid sim order
+const unsigned piNum = 32;
+const unsigned aigNum = 2000;
+
+vector<unsigned> gate, in0, in1;
+
+void
+initCircuit()
+{
+   srand(7);
+   for(unsigned i = 0; i < aigNum; ++i){
+      unsigned id = piNum + 1 + i;
+      gate.push_back(id);
+      in0.push_back(rand() % (2*id));
+      in1.push_back(rand() % (2*id));
+   }
+}
+
+// Run every kernel the CPU supports on the same random PI values and
+// compare the values of all gates against the scalar kernel
+bool
+testWords(unsigned words)
+{
+   const size_t size = (size_t)(piNum + aigNum + 1)*words;
+   vector<size_t> ref(size, 0);
+   for(size_t i = words; i < (size_t)(piNum + 1)*words; ++i)
+      ref[i] = ((size_t)rand() << 32) ^ (size_t)rand() ^ ((size_t)rand() << 48);
+
+   vector<size_t> init = ref;
+   simGatesFunc(SIM_SCALAR)(ref.data(), gate.data(), in0.data(), in1.data(), aigNum, words);
+
+   bool ok = true;
+   for(int isa = SIM_SCALAR + 1; isa < SIM_ISA_TOT; ++isa){
+      SimGatesFunc f = simGatesFunc(SimIsa(isa));
+      if(!f) continue;
+      vector<size_t> val = init;
+      f(val.data(), gate.data(), in0.data(), in1.data(), aigNum, words);
+      if(val != ref){
+         cout << simIsaStr(SimIsa(isa)) << " differs from scalar with "
+              << words << " word(s)" << endl;
+         ok = false;
+      }
+   }
+   return ok;
+}
+
+int
+main()
+{
+   initCircuit();
+
+   cout << "Kernels:";
+   for(int isa = SIM_SCALAR; isa < SIM_ISA_TOT; ++isa)
+      if(simGatesFunc(SimIsa(isa))) cout << " " << simIsaStr(SimIsa(isa));
+   cout << endl;
+
+   bool ok = true;
+   for(unsigned words = 1; words <= 33; ++words)
+      ok = testWords(words) && ok;
+
+   cout << (ok? "All kernels agree" : "Kernel mismatch!!") << endl;
+   return ok? 0 : 1;
+}
@@ -1,3 +0,0 @@
-main.o: main.cpp ../../include/util.h ../../include/rnGen.h \
- ../../include/myUsage.h ../../include/cmdParser.h \
- ../../include/cmdCharDef.h
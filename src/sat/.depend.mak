@@ -1,4 +0,0 @@
-File.o: File.cpp File.h Global.h
-Proof.o: Proof.cpp Proof.h SolverTypes.h Global.h File.h Sort.h
-Solver.o: Solver.cpp Solver.h SolverTypes.h Global.h VarOrder.h Heap.h \
- Proof.h File.h Sort.h
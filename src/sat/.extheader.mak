@@ -1,7 +1,10 @@
-sat.d: ../../include/sat.h ../../include/Solver.h ../../include/SolverTypes.h ../../include/VarOrder.h ../../include/Proof.h ../../include/Global.h ../../include/File.h ../../include/Heap.h ../../include/Sort.h 
+sat.d: ../../include/sat.h ../../include/aigSat.h ../../include/Solver.h ../../include/SolverTypes.h ../../include/VarOrder.h ../../include/Proof.h ../../include/Global.h ../../include/File.h ../../include/Heap.h ../../include/Sort.h 
 ../../include/sat.h: sat.h
 	@rm -f ../../include/sat.h
 	@ln -fs ../src/sat/sat.h ../../include/sat.h
+../../include/aigSat.h: aigSat.h
+	@rm -f ../../include/aigSat.h
+	@ln -fs ../src/sat/aigSat.h ../../include/aigSat.h
 ../../include/Solver.h: Solver.h
 	@rm -f ../../include/Solver.h
 	@ln -fs ../src/sat/Solver.h ../../include/Solver.h
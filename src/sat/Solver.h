@@ -32,14 +32,24 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 // Solver -- the main class:
 
 
+#define LBD_HIST 9      // 'lbd_hist[i]' counts learnt clauses of LBD 'i'; the last entry takes all larger ones.
+
 struct SolverStats {
     int64   starts, decisions, propagations, conflicts;
     int64   clauses_literals, learnts_literals, max_literals, tot_literals;
+    int64   lbd_hist[LBD_HIST];
     SolverStats() : starts(0), decisions(0), propagations(0), conflicts(0)
-      , clauses_literals(0), learnts_literals(0), max_literals(0), tot_literals(0) { }
+      , clauses_literals(0), learnts_literals(0), max_literals(0), tot_literals(0) {
+        for (int i = 0; i < LBD_HIST; i++) lbd_hist[i] = 0; }
 };
 
 
+// Restart schedules ('Solver::restart_mode', geometric by default):
+enum { restart_Geometric, restart_Luby, restart_Glucose };
+// Learnt clause removal ('Solver::reduce_mode', by activity by default):
+enum { reduce_Activity, reduce_LBD };
+
+
 struct SearchParams {
     double  var_decay, clause_decay, random_var_freq;    // (reasonable values are: 0.95, 0.999, 0.02)    
     SearchParams(double v = 1, double c = 1, double r = 0) : var_decay(v), clause_decay(c), random_var_freq(r) { }
@@ -51,8 +61,9 @@ protected:
     // Solver state:
     //
     bool                ok;               // If FALSE, the constraints are already unsatisfiable. No part of the solver state may be used!
-    vec<Clause*>        clauses;          // List of problem clauses.
-    vec<Clause*>        learnts;          // List of learnt clauses.
+    ClauseAllocator     ca;               // Region holding all clauses; the lists below refer into it.
+    vec<CRef>           clauses;          // List of problem clauses.
+    vec<CRef>           learnts;          // List of learnt clauses.
     vec<ClauseId>       unit_id;          // 'unit_id[var]' is the clause ID for the unit literal 'var' or '~var' (if set at toplevel).
     double              cla_inc;          // Amount to bump next clause with.
     double              cla_decay;        // INVERSE decay factor for clause activity: stores 1/decay.
@@ -61,12 +72,14 @@ protected:
     double              var_inc;          // Amount to bump next variable with.
     double              var_decay;        // INVERSE decay factor for variable activity: stores 1/decay. Use negative value for static variable order.
     VarOrder            order;            // Keeps track of the decision variable order.
+    vec<char>           polarity;         // 'polarity[var]' is the sign to branch on: seeded by 'setPolarity()', overwritten by phase saving.
 
-    vec<vec<Clause*> >  watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    vec<vec<Watcher> >  watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    vec<vec<Watcher> >  watches_bin;      // Same for binary clauses, which are kept apart and propagated first.
     vec<char>           assigns;          // The current assignments (lbool:s stored as char:s).
     vec<Lit>            trail;            // Assignment stack; stores all assigments made in the order they were made.
     vec<int>            trail_lim;        // Separator indices for different decision levels in 'trail[]'.
-    vec<Clause*>        reason;           // 'reason[var]' is the clause that implied the variables current value, or 'NULL' if none.
+    vec<CRef>           reason;           // 'reason[var]' is the clause that implied the variables current value, or 'CRef_Undef' if none.
     vec<int>            level;            // 'level[var]' is the decision level at which assignment was made.
     vec<int>            trail_pos;        // 'trail_pos[var]' is the variable's position in 'trail[]'. This supersedes 'level[]' in some sense, and 'level[]' will probably be removed in future releases.
     int                 root_level;       // Level of first proper decision.
@@ -79,8 +92,10 @@ protected:
     vec<char>           analyze_seen;
     vec<Lit>            analyze_stack;
     vec<Lit>            analyze_toclear;
-    Clause*             propagate_tmpbin;
-    Clause*             analyze_tmpbin;
+    vec<uint>           lbd_seen;         // 'lbd_seen[level]' is 'lbd_stamp' if 'level' was counted by the current 'lbdOf()'.
+    uint                lbd_stamp;
+    double              lbd_fast;         // Moving averages of the LBD of learnt clauses over the last ~32 conflicts
+    double              lbd_slow;         // and over the last ~16k conflicts (for 'restart_Glucose').
     vec<Lit>            addUnit_tmp;
     vec<Lit>            addBinary_tmp;
     vec<Lit>            addTernary_tmp;
@@ -91,12 +106,19 @@ protected:
     void        cancelUntil      (int level);
     void        record           (const vec<Lit>& clause);
 
-    void        analyze          (Clause* confl, vec<Lit>& out_learnt, int& out_btlevel); // (bt = backtrack)
+    void        analyze          (CRef confl, vec<Lit>& out_learnt, int& out_btlevel);    // (bt = backtrack)
     bool        analyze_removable(Lit p, uint min_level);                                 // (helper method for 'analyze()')
-    void        analyzeFinal     (Clause* confl, bool skip_first = false);
-    bool        enqueue          (Lit fact, Clause* from = NULL);
-    Clause*     propagate        ();
+    void        analyzeFinal     (CRef confl, bool skip_first = false);
+    bool        enqueue          (Lit fact, CRef from = CRef_Undef);
+    CRef        propagate        ();
+    void        logUnit          (const Clause& c, Lit first);                            // (helper method for 'propagate()')
+    CRef        reasonFor        (Var x);
+    template<class C>
+    uint        lbdOf            (const C& ps);                                           // Number of distinct decision levels in 'ps'.
     void        reduceDB         ();
+    void        checkGarbage     () { if (ca.wasted() > ca.size() * garbage_frac) garbageCollect(); }
+    void        garbageCollect   ();
+    void        relocAll         (ClauseAllocator& to);
     Lit         pickBranchLit    (const SearchParams& params);
     lbool       search           (int nof_conflicts, int nof_learnts, const SearchParams& params);
     double      progressEstimate ();
@@ -115,13 +137,24 @@ protected:
     // Operations on clauses:
     //
     void     newClause(const vec<Lit>& ps, bool learnt = false, ClauseId id = ClauseId_NULL, bool A = true);
-    void     claBumpActivity (Clause* c) { if ( (c->activity() += cla_inc) > 1e20 ) claRescaleActivity(); }
-    void     remove          (Clause* c, bool just_dealloc = false);
-    bool     locked          (const Clause* c) const { return reason[var((*c)[0])] == c; }
-    bool     simplify        (Clause* c) const;
+    void     attach          (CRef cr);
+    void     claBumpActivity (Clause& c) { if ( (c.activity() += cla_inc) > 1e20 ) claRescaleActivity(); }
+    void     remove          (CRef cr);
+    bool     locked          (CRef cr) const {
+        const Clause& c = ca[cr];
+        return reason[var(c[0])] == cr || (c.size() == 2 && reason[var(c[1])] == cr); }
+    bool     simplify        (const Clause& c) const;
 
     int      decisionLevel() const { return trail_lim.size(); }
 
+    // Resource limits: (absolute values of 'stats'; negative means no limit)
+    //
+    int64    conflict_budget;
+    int64    propagation_budget;
+    bool     withinBudget() const {
+        return (conflict_budget    < 0 || stats.conflicts    < conflict_budget)
+            && (propagation_budget < 0 || stats.propagations < propagation_budget); }
+
 public:
     Solver() : ok               (true)
              , cla_inc          (1)
@@ -132,27 +165,29 @@ public:
              , qhead            (0)
              , simpDB_assigns   (0)
              , simpDB_props     (0)
+             , lbd_stamp        (0)
+             , lbd_fast         (0)
+             , lbd_slow         (0)
+             , conflict_budget  (-1)
+             , propagation_budget(-1)
              , default_params   (SearchParams(0.95, 0.999, 0.02))
              , expensive_ccmin  (2)
+             , restart_mode     (restart_Geometric)
+             , reduce_mode      (reduce_Activity)
+             , phase_saving     (true)
+             , garbage_frac     (0.20)
              , proof            (NULL)
              , verbosity        (0)
              , progress_estimate(0)
              , conflict_id      (ClauseId_NULL)
              {
-                vec<Lit> dummy(2,lit_Undef);
-                propagate_tmpbin = Clause_new(false, dummy);
-                analyze_tmpbin   = Clause_new(false, dummy);
                 addUnit_tmp   .growTo(1);
                 addBinary_tmp .growTo(2);
                 addTernary_tmp.growTo(3);
+                lbd_seen      .push(0);     // (for level 0; 'newVar()' adds one level per variable)
              }
 
-   ~Solver() {
-       for (int i = 0; i < learnts.size(); i++) remove(learnts[i], true);
-       for (int i = 0; i < clauses.size(); i++) if (clauses[i] != NULL) remove(clauses[i], true);
-       remove(propagate_tmpbin, true);
-       remove(analyze_tmpbin, true);
-    }
+   ~Solver() { }    // (clauses are released with 'ca')
 
     // Helpers: (semi-internal)
     //
@@ -173,6 +208,10 @@ public:
     //
     SearchParams    default_params;     // Restart frequency etc.
     int             expensive_ccmin;    // Controls conflict clause minimization. TRUE by default.
+    int             restart_mode;       // Restart schedule: geometric (x1.5), Luby (unit 100 conflicts) or glucose (LBD averages).
+    int             reduce_mode;        // Learnt clauses are removed by activity, or by LBD keeping all "glue" clauses (LBD <= 2).
+    bool            phase_saving;       // Branch on the sign a variable last had before backtracking. TRUE by default.
+    double          garbage_frac;       // Compact the clause region when this fraction of it is held by removed clauses.
     Proof*          proof;              // Set this directly after constructing 'Solver' to enable proof logging. Initialized to NULL.
     int             verbosity;          // Verbosity level. 0=silent, 1=some progress report, 2=everything
 
@@ -180,6 +219,7 @@ public:
     //
     Var     newVar    ();
     int     nVars     ()                    { return assigns.size(); }
+    void    setPolarity(Var v, bool b)      { polarity[v] = (char)b; }    // Branch on '~v' if 'b' is TRUE (the default), else on 'v'.
     void    addUnit   (Lit p)               { addUnit_tmp   [0] = p; addClause(addUnit_tmp); }
     void    addBinary (Lit p, Lit q)        { addBinary_tmp [0] = p; addBinary_tmp [1] = q; addClause(addBinary_tmp); }
     void    addTernary(Lit p, Lit q, Lit r) { addTernary_tmp[0] = p; addTernary_tmp[1] = q; addTernary_tmp[2] = r; addClause(addTernary_tmp); }
@@ -190,9 +230,16 @@ public:
     //
     bool    okay() { return ok; }       // FALSE means solver is in an conflicting state (must never be used again!)
     void    simplifyDB();
-    bool    solve(const vec<Lit>& assumps);
+    lbool   solveLimited(const vec<Lit>& assumps);
+    bool    solve(const vec<Lit>& assumps) { budgetOff(); return solveLimited(assumps) == l_True; }
     bool    solve() { vec<Lit> tmp; return solve(tmp); }
 
+    // Budgets count from the current statistics and hold for the following 'solveLimited()' calls:
+    //
+    void    setConfBudget(int64 x) { conflict_budget    = (x < 0) ? -1 : stats.conflicts    + x; }
+    void    setPropBudget(int64 x) { propagation_budget = (x < 0) ? -1 : stats.propagations + x; }
+    void    budgetOff()            { conflict_budget = propagation_budget = -1; }
+
     double      progress_estimate;  // Set by 'search()'.
     vec<lbool>  model;              // If problem is satisfiable, this vector contains the model (if any).
     vec<Lit>    conflict;           // If problem is unsatisfiable under assumptions, this vector represent the conflict clause expressed in the assumptions.
@@ -204,6 +251,22 @@ public:
 };
 
 
+template<class C>
+inline uint Solver::lbdOf(const C& ps)
+{
+    if (++lbd_stamp == 0){
+        for (int i = 0; i < lbd_seen.size(); i++) lbd_seen[i] = 0;
+        lbd_stamp = 1; }
+    uint n = 0;
+    for (int i = 0; i < ps.size(); i++){
+        int l = level[var(ps[i])];
+        if (lbd_seen[l] != lbd_stamp)
+            lbd_seen[l] = lbd_stamp, n++;
+    }
+    return n;
+}
+
+
 //=================================================================================================
 // Debug:
 
@@ -81,36 +81,142 @@ const   int ClauseId_NULL = INT_MIN;
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
+// Clauses live in a 'ClauseAllocator' and are referred to by 32-bit offsets into it:
+typedef uint CRef;
+const   CRef CRef_Undef = UINT_MAX;
+
 class Clause {
-    uint    size_learnt;
+    uint    header;     // size << 4 | reloced << 3 | deleted << 2 | has_id << 1 | learnt
     Lit     data[1];
-public:
+
     // NOTE: This constructor cannot be used directly (doesn't allocate enough memory).
-    Clause(bool learnt, const vec<Lit>& ps, ClauseId id_ = ClauseId_NULL) {
-        size_learnt = (ps.size() << 1) | (int)learnt;
+    template<class V>
+    Clause(bool learnt, const V& ps, ClauseId id_) {
+        header = (ps.size() << 4) | ((int)(id_ != ClauseId_NULL) << 1) | (int)learnt;
         for (int i = 0; i < ps.size(); i++) data[i] = ps[i];
-        if (learnt) activity() = 0;
+        if (learnt) activity() = 0, lbd() = 0;
         if (id_ != ClauseId_NULL) id() = id_; }
 
-    // -- use this function instead:
-    friend Clause* Clause_new(bool, const vec<Lit>&, ClauseId);
+    // -- use 'ClauseAllocator::alloc()' instead:
+    friend class ClauseAllocator;
 
-    int       size        ()      const { return size_learnt >> 1; }
-    bool      learnt      ()      const { return size_learnt & 1; }
+public:
+    int       size        ()      const { return header >> 4; }
+    bool      learnt      ()      const { return header & 1; }
+    bool      hasId       ()      const { return header & 2; }
+    bool      deleted     ()      const { return header & 4; }
+    bool      reloced     ()      const { return header & 8; }
+    CRef      relocation  ()      const { return *((CRef*)&data[0]); }      // (valid if 'reloced()')
+    int       words       ()      const { return 1 + size() + 2*(int)learnt() + (int)hasId(); }
     Lit       operator [] (int i) const { return data[i]; }
     Lit&      operator [] (int i)       { return data[i]; }
     float&    activity    ()      const {
         void *p = const_cast<Lit*>(&data[size()]); return *((float *)p);
     } //              return *((float*)&data[size()]); }
-    ClauseId& id          ()      const { return *((ClauseId*)&data[size() + (int)learnt()]); }
+    uint&     lbd         ()      const { return *((uint*)&data[size() + 1]); }     // (learnt clauses only)
+    ClauseId& id          ()      const { return *((ClauseId*)&data[size() + 2*(int)learnt()]); }
+};
+
+
+//=================================================================================================
+// ClauseAllocator -- a region holding all clauses of a solver:
+
+
+// Clauses are placed one after another in a single block of words, so the clauses visited by
+// 'propagate()' share cache lines and a reference fits in 32 bits. 'free()' only marks a clause;
+// the space is reclaimed by copying the live clauses into a fresh region with 'reloc()' and
+// taking it over with 'moveTo()'.
+class ClauseAllocator {
+    uint*   memory;
+    uint    sz;
+    uint    cap;
+    uint    wasted_;
+
+    void capacity(uint min_cap) {
+        if (cap >= min_cap) return;
+        uint prev_cap = cap;
+        while (cap < min_cap){
+            uint delta = ((cap >> 1) + (cap >> 3) + 2) & ~1;   // (grow by ~1.6 -- ~1.5 for lack of precision)
+            cap += delta;
+            assert(cap > prev_cap && "clause region exceeds 2^32 words"); }
+        memory = xrealloc(memory, cap); }
+
+public:
+    ClauseAllocator(uint start_cap = 0) : memory(NULL), sz(0), cap(0), wasted_(0) { capacity(start_cap); }
+   ~ClauseAllocator() { if (memory != NULL) xfree(memory); }
+
+    uint     size  () const { return sz; }
+    uint     wasted() const { return wasted_; }
+
+    // NOTE! May move the region: references ('Clause&') obtained before are invalidated.
+    template<class V>
+    CRef alloc(bool learnt, const V& ps, ClauseId id = ClauseId_NULL) {
+        assert(sizeof(Lit)      == sizeof(uint));
+        assert(sizeof(float)    == sizeof(uint));
+        assert(sizeof(ClauseId) == sizeof(uint));
+        uint words = 1 + ps.size() + 2*(int)learnt + (int)(id != ClauseId_NULL);
+        capacity(sz + words);
+        CRef r = sz;
+        sz += words;
+        new (&memory[r]) Clause(learnt, ps, id);
+        return r; }
+
+    void free(CRef r) {
+        Clause& c = (*this)[r];
+        assert(!c.deleted());
+        c.header |= 4;
+        wasted_ += c.words(); }
+
+    // Copy clause 'r' into 'to' (once) and return its new reference.
+    CRef reloc(CRef r, ClauseAllocator& to) {
+        Clause& c = (*this)[r];
+        if (c.reloced()) return c.relocation();
+        assert(!c.deleted());
+        CRef n = to.alloc(c.learnt(), c, c.hasId() ? c.id() : ClauseId_NULL);
+        if (c.learnt()) to[n].activity() = c.activity(), to[n].lbd() = c.lbd();
+        c.header |= 8;
+        *((CRef*)&c.data[0]) = n;
+        return n; }
+
+    void moveTo(ClauseAllocator& to) {
+        if (to.memory != NULL) xfree(to.memory);
+        to.memory = memory; to.sz = sz; to.cap = cap; to.wasted_ = wasted_;
+        memory = NULL; sz = cap = wasted_ = 0; }
+
+    Clause&       operator [] (CRef r)       { return (Clause&)memory[r]; }
+    const Clause& operator [] (CRef r) const { return (const Clause&)memory[r]; }
+};
+
+
+//=================================================================================================
+// Watcher -- an entry of a watch list:
+
+
+// 'blocker' is some literal of clause 'cref'; while it is true the clause is satisfied and need not be
+// inspected. For binary clauses it is the other literal, so they propagate without being touched.
+struct Watcher {
+    CRef    cref;
+    Lit     blocker;
+    Watcher() {}
+    Watcher(CRef c, Lit p) : cref(c), blocker(p) {}
 };
 
-inline Clause* Clause_new(bool learnt, const vec<Lit>& ps, ClauseId id = ClauseId_NULL) {
-    assert(sizeof(Lit)      == sizeof(uint));
-    assert(sizeof(float)    == sizeof(uint));
-    assert(sizeof(ClauseId) == sizeof(uint));
-    void*   mem = xmalloc<char>(sizeof(Clause) + sizeof(uint)*(ps.size() + (int)learnt + (int)(id != ClauseId_NULL)));
-    return new (mem) Clause(learnt, ps, id); }
+
+//=================================================================================================
+// Helpers shared by 'Solver' and 'AigSolver' (defined in 'Solver.cpp'):
+
+
+// Finite subsequences of the Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, ... scaled by 'y' instead of 2:
+double luby(double y, int x);
+
+// Remove the watcher of clause 'elem' from 'ws':
+void removeWatch(vec<Watcher>& ws, CRef elem);
+
+// Order of learnt clauses for removal by activity: binary clauses last, the others least active first.
+struct reduceDB_lt {
+    const ClauseAllocator& ca;
+    reduceDB_lt(const ClauseAllocator& ca_) : ca(ca_) {}
+    bool operator () (CRef x, CRef y) const { return ca[x].size() > 2 && (ca[y].size() == 2 || ca[x].activity() < ca[y].activity()); } };
 
 
 //=================================================================================================
@@ -0,0 +1,664 @@
+/****************************************************************************
+  FileName     [ aigSat.cpp ]
+  PackageName  [ sat ]
+  Synopsis     [ Define circuit SAT solver working on the AIG itself ]
+  Author       [ Chien-You (Benny) Huang ]
+  Copyright    [ Copyleft(c) 2010-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include "aigSat.h"
+#include "Sort.h"
+
+using namespace std;
+
+const uint AigSolver::NoReason;
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+// luby(), removeWatch() and reduceDB_lt are shared with 'Solver'
+// (see SolverTypes.h)
+
+/*******************************************/
+/*   Construction of the problem           */
+/*******************************************/
+AigSolver::AigSolver()
+   : _ok(true), _qhead(0), _varInc(1), _claInc(1), _maxLearnts(0),
+     _simpProps(0), _simpAssigns(-1), _confBudget(-1), _propBudget(-1),
+     _confLimit(-1), _propLimit(-1), _conflicts(0), _decisions(0),
+     _propagations(0)
+{
+}
+
+void
+AigSolver::reset()
+{
+   _ext.clear(true); _miter.clear(true);
+   _fanin0.clear(true); _fanin1.clear(true); _fanout.clear(true);
+   ClauseAllocator().moveTo(_ca);
+   _clauses.clear(true); _learnts.clear(true); _watches.clear(true);
+   _assigns.clear(true); _level.clear(true); _trailPos.clear(true);
+   _reason.clear(true); _trail.clear(true); _trailLim.clear(true);
+   _assump.clear(true); _jStack.clear(true); _jRestore.clear(true);
+   _activity.clear(true); _polarity.clear(true); _seen.clear(true);
+   _model.clear(true);
+   _ok = true; _qhead = 0; _varInc = 1; _claInc = 1; _maxLearnts = 0;
+   _simpProps = 0; _simpAssigns = -1;
+   _conflicts = _decisions = _propagations = 0;
+}
+
+Var
+AigSolver::newVar()
+{
+   Var v = _ext.size();
+   _ext.push(Lit(newNode(lit_Undef, lit_Undef)));
+   _miter.push(var_Undef);
+   return v;
+}
+
+void
+AigSolver::addAigCNF(Var vf, Var va, bool fa, Var vb, bool fb)
+{
+   Lit f = _ext[vf];
+   assert(!sign(f));
+   defineGate(var(f), fa? ~_ext[va]: _ext[va], fb? ~_ext[vb]: _ext[vb]);
+}
+
+// The node made for "vf" by newVar() is left unused
+void
+AigSolver::addXorCNF(Var vf, Var va, bool fa, Var vb, bool fb)
+{
+   assert(!isGate(var(_ext[vf])) && _fanout[var(_ext[vf])].size() == 0);
+   Var n = newXor(fa? ~_ext[va]: _ext[va], fb? ~_ext[vb]: _ext[vb]);
+   _ext[vf] = ~Lit(n);
+}
+
+void
+AigSolver::addMiterCNF(Var vf, Var va, Var vb, bool fb)
+{
+   Var n = newXor(_ext[va], fb? ~_ext[vb]: _ext[vb]);
+   _miter[vf] = n;
+   vec<Lit> ps;
+   ps.push(~_ext[vf]); ps.push(~Lit(n));
+   addClause(ps);
+}
+
+void
+AigSolver::addEqCNF(Var va, Var vb, bool fb)
+{
+   Lit a = _ext[va], b = fb? ~_ext[vb]: _ext[vb];
+   vec<Lit> ps;
+   ps.push(~a); ps.push(b);
+   addClause(ps);
+   ps.clear();
+   ps.push(a); ps.push(~b);
+   addClause(ps);
+}
+
+void
+AigSolver::assertProperty(Var prop, bool val)
+{
+   // A retired miter is unhooked from its fanins and its nodes become
+   // free, so it costs nothing in later propagation.  Nothing else reads
+   // them, so the clauses learnt through them still hold.
+   Var n = _miter[prop];
+   if (!val && n != var_Undef) {
+      Var t0 = var(_fanin0[n]), t1 = var(_fanin1[n]);
+      undefineGate(n); undefineGate(t0); undefineGate(t1);
+      _miter[prop] = var_Undef;
+   }
+   vec<Lit> ps;
+   ps.push(val? _ext[prop]: ~_ext[prop]);
+   addClause(ps);
+}
+
+Var
+AigSolver::newNode(Lit a, Lit b)
+{
+   Var v = _assigns.size();
+   _fanin0.push(lit_Undef);
+   _fanin1.push(lit_Undef);
+   _fanout.push();
+   _watches.push(); _watches.push();
+   _assigns.push(toInt(l_Undef));
+   _level.push(-1);
+   _trailPos.push(-1);
+   _reason.push(NoReason);
+   _activity.push(0);
+   _polarity.push(1);
+   _seen.push(0);
+   if (a != lit_Undef) defineGate(v, a, b);
+   return v;
+}
+
+// Turn free node "n" into an AND gate.  Values of its fanins assigned
+// before are checked when "n" itself gets a value.
+void
+AigSolver::defineGate(Var n, Lit a, Lit b)
+{
+   assert(!isGate(n) && value(n) == l_Undef);
+   assert(var(a) < n && var(b) < n);
+   _fanin0[n] = a;
+   _fanin1[n] = b;
+   _fanout[var(a)].push(n);
+   if (var(b) != var(a)) _fanout[var(b)].push(n);
+}
+
+// Return node "n" = XNOR(a, b), i.e. the negation of a ^ b
+Var
+AigSolver::newXor(Lit a, Lit b)
+{
+   Var t0 = newNode(a, ~b);
+   Var t1 = newNode(~a, b);
+   return newNode(~Lit(t0), ~Lit(t1));
+}
+
+// Turn gate "n" back into a free node
+void
+AigSolver::undefineGate(Var n)
+{
+   assert(decisionLevel() == 0);
+   removeFanout(var(_fanin0[n]), n);
+   removeFanout(var(_fanin1[n]), n);
+   _fanin0[n] = _fanin1[n] = lit_Undef;
+}
+
+void
+AigSolver::removeFanout(Var x, Var g)
+{
+   vec<Var>& fo = _fanout[x];
+   for (int i = 0; i < fo.size(); i++)
+      if (fo[i] == g) { fo[i] = fo.last(); fo.pop(); return; }
+}
+
+// Add a problem clause at level 0
+void
+AigSolver::addClause(vec<Lit>& ps)
+{
+   assert(decisionLevel() == 0);
+   if (!_ok) return;
+   sortUnique(ps);
+   int j = 0;
+   for (int i = 0; i < ps.size(); i++) {
+      if (value(ps[i]) == l_True || (i && ps[i] == ~ps[i-1])) return;
+      if (value(ps[i]) != l_False) ps[j++] = ps[i];
+   }
+   ps.shrink(ps.size() - j);
+   if (ps.size() == 0) { _ok = false; return; }
+   if (ps.size() == 1) { enqueue(ps[0], NoReason); return; }
+   CRef cr = _ca.alloc(false, ps);
+   _clauses.push(cr);
+   attach(cr);
+}
+
+void
+AigSolver::attach(CRef cr)
+{
+   const Clause& c = _ca[cr];
+   _watches[index(~c[0])].push(Watcher(cr, c[1]));
+   _watches[index(~c[1])].push(Watcher(cr, c[0]));
+}
+
+/*******************************************/
+/*   Propagation                           */
+/*******************************************/
+void
+AigSolver::enqueue(Lit p, uint from)
+{
+   assert(value(p) == l_Undef);
+   Var x = var(p);
+   _assigns[x] = toInt(lbool(!sign(p)));
+   _level[x] = decisionLevel();
+   _trailPos[x] = _trail.size();
+   _reason[x] = from;
+   _trail.push(p);
+}
+
+void
+AigSolver::newDecisionLevel()
+{
+   _trailLim.push(_trail.size());
+   while (_jRestore.size() <= decisionLevel()) _jRestore.push();
+}
+
+void
+AigSolver::cancelUntil(int level)
+{
+   const int top = decisionLevel();
+   if (top <= level) return;
+   for (int c = _trail.size()-1; c >= _trailLim[level]; c--) {
+      Var x = var(_trail[c]);
+      _assigns[x] = toInt(l_Undef);
+      _reason[x] = NoReason;
+      _polarity[x] = (char)sign(_trail[c]);      // (phase saving)
+   }
+   _trail.shrink(_trail.size() - _trailLim[level]);
+   _trailLim.shrink(_trailLim.size() - level);
+   _qhead = _trail.size();
+   // J-nodes that lost their justification
+   for (int l = level+1; l <= top; l++) {
+      vec<Var>& rs = _jRestore[l];
+      for (int i = 0; i < rs.size(); i++)
+         if (value(rs[i]) == l_False) _jStack.push(rs[i]);
+      rs.clear();
+   }
+}
+
+// Return false on conflict, with the falsified clause in _conflict
+bool
+AigSolver::propagate()
+{
+   while (_qhead < _trail.size()) {
+      Lit p = _trail[_qhead++];
+      Var x = var(p);
+      _propagations++;
+      _simpProps--;
+      if (isGate(x)) {
+         if (!propagateGate(x)) return false;
+         if (sign(p) && value(_fanin0[x]) != l_False && value(_fanin1[x]) != l_False)
+            _jStack.push(x);
+      }
+      const vec<Var>& fo = _fanout[x];
+      for (int i = 0; i < fo.size(); i++)
+         if (!propagateGate(fo[i])) return false;
+      if (!propagateClauses(p)) return false;
+   }
+   return true;
+}
+
+// Apply the three clauses of gate "g" to the current values
+bool
+AigSolver::propagateGate(Var g)
+{
+   Lit a = _fanin0[g], b = _fanin1[g];
+   lbool vg = value(g), va = value(a), vb = value(b);
+   if (va == l_False || vb == l_False) {
+      if (vg == l_True) { gateConflict(g); return false; }
+      if (vg == l_Undef) enqueue(~Lit(g), gateReason(g));
+   }
+   else if (va == l_True && vb == l_True) {
+      if (vg == l_False) { gateConflict(g); return false; }
+      if (vg == l_Undef) enqueue(Lit(g), gateReason(g));
+   }
+   else if (vg == l_True) {
+      if (va == l_Undef) enqueue(a, gateReason(g));
+      if (value(b) == l_False) { gateConflict(g); return false; }   // (b == ~a)
+      if (value(b) == l_Undef) enqueue(b, gateReason(g));
+   }
+   else if (vg == l_False) {
+      if (va == l_True && vb == l_Undef) enqueue(~b, gateReason(g));
+      else if (vb == l_True && va == l_Undef) enqueue(~a, gateReason(g));
+   }
+   return true;
+}
+
+void
+AigSolver::gateConflict(Var g)
+{
+   Lit a = _fanin0[g], b = _fanin1[g];
+   _conflict.clear();
+   if (value(g) == l_True) {
+      _conflict.push(~Lit(g));
+      _conflict.push(value(a) == l_False? a: b);
+   }
+   else {
+      _conflict.push(Lit(g));
+      _conflict.push(~a);
+      if (b != a) _conflict.push(~b);
+   }
+}
+
+bool
+AigSolver::propagateClauses(Lit p)
+{
+   Lit false_lit = ~p;
+   vec<Watcher>& ws = _watches[index(p)];
+   Watcher *i, *j, *end;
+   for (i = j = (Watcher*)ws, end = i + ws.size(); i != end;) {
+      Lit blocker = i->blocker;
+      if (value(blocker) == l_True) { *j++ = *i++; continue; }
+
+      CRef cr = i->cref;
+      Clause& c = _ca[cr]; i++;
+      if (c[0] == false_lit) c[0] = c[1], c[1] = false_lit;
+      Lit first = c[0];
+      Watcher w(cr, first);
+      if (first != blocker && value(first) == l_True) { *j++ = w; continue; }
+
+      for (int k = 2; k < c.size(); k++)
+         if (value(c[k]) != l_False) {
+            c[1] = c[k]; c[k] = false_lit;
+            _watches[index(~c[1])].push(w);
+            goto FoundWatch;
+         }
+
+      *j++ = w;
+      if (value(first) == l_False) {
+         _conflict.clear();
+         for (int k = 0; k < c.size(); k++) _conflict.push(c[k]);
+         if (c.learnt()) claBump(c);
+         while (i < end) *j++ = *i++;
+         ws.shrink(i - j);
+         return false;
+      }
+      enqueue(first, clauseReason(cr));
+     FoundWatch:;
+   }
+   ws.shrink(i - j);
+   return true;
+}
+
+/*******************************************/
+/*   Conflict analysis                     */
+/*******************************************/
+// Collect the false literals of the clause that implied the value of "x"
+void
+AigSolver::reasonLits(Var x, vec<Lit>& out)
+{
+   out.clear();
+   uint r = _reason[x];
+   assert(r != NoReason);
+   if (!isGateReason(r)) {
+      Clause& c = _ca[r >> 1];
+      if (c.learnt()) claBump(c);
+      for (int i = 0; i < c.size(); i++)
+         if (var(c[i]) != x) out.push(c[i]);
+      return;
+   }
+   Var g = r >> 1;
+   Lit a = _fanin0[g], b = _fanin1[g];
+   if (x == g) {
+      if (value(g) == l_True) {
+         out.push(~a);
+         if (b != a) out.push(~b);
+      }
+      else {
+         // a fanin that was false before "g"
+         bool fa = value(a) == l_False && _trailPos[var(a)] < _trailPos[g];
+         out.push(fa? a: b);
+      }
+   }
+   else if (value(g) == l_True)
+      out.push(~Lit(g));
+   else {
+      out.push(Lit(g));
+      Lit other = (var(a) == x)? b: a;
+      if (var(other) != x) out.push(~other);
+   }
+}
+
+// First-UIP learning from _conflict; "out_learnt[0]" is the asserting
+// literal and "out_learnt[1]" one of "out_btlevel"
+void
+AigSolver::analyze(vec<Lit>& out_learnt, int& out_btlevel)
+{
+   int pathC = 0;
+   Lit p = lit_Undef;
+   out_learnt.clear();
+   out_learnt.push();
+   int index = _trail.size() - 1;
+   _conflict.copyTo(_lits);
+   for (;;) {
+      for (int j = 0; j < _lits.size(); j++) {
+         Lit q = _lits[j];
+         Var v = var(q);
+         if (_seen[v] || _level[v] == 0) continue;
+         varBump(v);
+         _seen[v] = 1;
+         if (_level[v] == decisionLevel()) pathC++;
+         else out_learnt.push(q);
+      }
+      while (!_seen[var(_trail[index--])]);
+      p = _trail[index+1];
+      _seen[var(p)] = 0;
+      if (--pathC == 0) break;
+      reasonLits(var(p), _lits);
+   }
+   out_learnt[0] = ~p;
+
+   // Drop literals implied by the other ones
+   out_learnt.copyTo(_toClear);
+   int i, j;
+   for (i = j = 1; i < out_learnt.size(); i++) {
+      Var v = var(out_learnt[i]);
+      if (_reason[v] == NoReason) { out_learnt[j++] = out_learnt[i]; continue; }
+      reasonLits(v, _lits);
+      for (int k = 0; k < _lits.size(); k++)
+         if (!_seen[var(_lits[k])] && _level[var(_lits[k])] > 0) {
+            out_learnt[j++] = out_learnt[i];
+            break;
+         }
+   }
+   out_learnt.shrink(i - j);
+   for (int k = 0; k < _toClear.size(); k++) _seen[var(_toClear[k])] = 0;
+
+   out_btlevel = 0;
+   if (out_learnt.size() > 1) {
+      int max_i = 1;
+      for (int k = 2; k < out_learnt.size(); k++)
+         if (_level[var(out_learnt[k])] > _level[var(out_learnt[max_i])]) max_i = k;
+      Lit tmp = out_learnt[1];
+      out_learnt[1] = out_learnt[max_i];
+      out_learnt[max_i] = tmp;
+      out_btlevel = _level[var(out_learnt[1])];
+   }
+}
+
+/*******************************************/
+/*   Search                                */
+/*******************************************/
+// Justify the newest J-node: make one of its fanins 0, preferring the
+// fanin whose saved (or seeded) value is 0, then the more active one.
+// Return lit_Undef if every assigned gate is justified.
+Lit
+AigSolver::pickBranchLit()
+{
+   while (_jStack.size()) {
+      Var g = _jStack.last();
+      if (!isGate(g) || value(g) != l_False) { _jStack.pop(); continue; }
+      Lit a = _fanin0[g], b = _fanin1[g];
+      lbool va = value(a), vb = value(b);
+      if (va == l_False || vb == l_False) {
+         int lf = (va == l_False)? _level[var(a)]: _level[var(b)];
+         if (vb == l_False && _level[var(b)] < lf) lf = _level[var(b)];
+         if (lf > _level[g]) _jRestore[lf].push(g);
+         _jStack.pop();
+         continue;
+      }
+      assert(va == l_Undef && vb == l_Undef);
+      bool za = (_polarity[var(a)] != 0) != sign(a);   // (a prefers 0)
+      bool zb = (_polarity[var(b)] != 0) != sign(b);
+      if (za != zb) return za? ~a: ~b;
+      return (_activity[var(b)] > _activity[var(a)])? ~b: ~a;
+   }
+   return lit_Undef;
+}
+
+// Rebuild the J-frontier at level 0, dropping its stale entries
+void
+AigSolver::resetJFrontier()
+{
+   assert(decisionLevel() == 0);
+   _jStack.clear();
+   for (int i = 0; i < _trail.size(); i++) {
+      Var x = var(_trail[i]);
+      if (isGate(x) && sign(_trail[i]) && value(_fanin0[x]) != l_False && value(_fanin1[x]) != l_False)
+         _jStack.push(x);
+   }
+}
+
+// Return 1/0 for SAT/UNSAT, -1 if the budget ran out and -2 to restart
+int
+AigSolver::search(int nof_conflicts)
+{
+   int conflictC = 0;
+   for (;;) {
+      if (!propagate()) {
+         _conflicts++; conflictC++;
+         if (decisionLevel() == 0) { _ok = false; return 0; }
+         int btlevel;
+         analyze(_learnt, btlevel);
+         cancelUntil(btlevel);
+         if (_learnt.size() == 1)
+            enqueue(_learnt[0], NoReason);
+         else {
+            CRef cr = _ca.alloc(true, _learnt);
+            _learnts.push(cr);
+            attach(cr);
+            claBump(_ca[cr]);
+            enqueue(_learnt[0], clauseReason(cr));
+         }
+         _varInc *= 1 / 0.95;
+         _claInc *= 1 / 0.999;
+         continue;
+      }
+      if (!withinBudget()) return -1;
+      if (nof_conflicts >= 0 && conflictC >= nof_conflicts) return -2;
+      if (decisionLevel() == 0) simplify();
+      if (_learnts.size() - _trail.size() >= (int)_maxLearnts) reduceDB();
+
+      Lit next = lit_Undef;
+      while (decisionLevel() < _assump.size()) {
+         Lit p = _assump[decisionLevel()];
+         if (value(p) == l_False) return 0;
+         if (value(p) == l_True) newDecisionLevel();
+         else { next = p; break; }
+      }
+      if (next == lit_Undef) {
+         next = pickBranchLit();
+         if (next == lit_Undef) { buildModel(); return 1; }
+         _decisions++;
+      }
+      newDecisionLevel();
+      enqueue(next, NoReason);
+   }
+}
+
+int
+AigSolver::assumpSolveLimited()
+{
+   _model.clear();
+   if (!_ok) return 0;
+   _confLimit = (_confBudget < 0)? -1: _conflicts + _confBudget;
+   _propLimit = (_propBudget < 0)? -1: _propagations + _propBudget;
+   if (!propagate()) { _ok = false; return 0; }
+   _maxLearnts = _fanin0.size()/3 + 1000;
+
+   int status = -2;
+   for (int restarts = 0; status == -2; restarts++) {
+      status = search((int)(luby(2, restarts) * 100));
+      cancelUntil(0);
+      resetJFrontier();
+      if (status == -2 && !withinBudget()) status = -1;
+      _maxLearnts *= 1.1;
+   }
+   return status;
+}
+
+// Inputs left free take their saved values; gates are simulated.  Every
+// assigned gate is justified, so simulation reproduces its value.
+void
+AigSolver::buildModel()
+{
+   const int n = _assigns.size();
+   _model.growTo(n);
+   for (int x = 0; x < n; x++) {
+      if (isGate(x)) {
+         Lit a = _fanin0[x], b = _fanin1[x];
+         _model[x] = (_model[var(a)] != sign(a)) && (_model[var(b)] != sign(b));
+         assert(value(x) == l_Undef || (value(x) == l_True) == (bool)_model[x]);
+      }
+      else if (value(x) != l_Undef)
+         _model[x] = (value(x) == l_True);
+      else
+         _model[x] = !_polarity[x];
+   }
+}
+
+/*******************************************/
+/*   Clause database                       */
+/*******************************************/
+// Remove clauses satisfied at level 0
+void
+AigSolver::simplify()
+{
+   if ((int)_trail.size() == _simpAssigns || _simpProps > 0) return;
+   for (int type = 0; type < 2; type++) {
+      vec<CRef>& cs = type? _learnts: _clauses;
+      int j = 0;
+      for (int i = 0; i < cs.size(); i++) {
+         const Clause& c = _ca[cs[i]];
+         bool sat = false;
+         for (int k = 0; k < c.size() && !sat; k++) sat = (value(c[k]) == l_True);
+         if (sat) _ca.free(cs[i]);
+         else cs[j++] = cs[i];
+      }
+      cs.shrink(cs.size() - j);
+   }
+   // level-0 reasons are never looked at again
+   for (int i = 0; i < _trail.size(); i++) _reason[var(_trail[i])] = NoReason;
+   cleanWatches();
+   checkGarbage();
+   _simpAssigns = _trail.size();
+   _simpProps = _ca.size();
+}
+
+// Remove the less active half of the learnt clauses
+void
+AigSolver::reduceDB()
+{
+   sort(_learnts, reduceDB_lt(_ca));
+   int i, j;
+   for (i = j = 0; i < _learnts.size(); i++) {
+      CRef cr = _learnts[i];
+      if (i < _learnts.size()/2 && _ca[cr].size() > 2 && !locked(cr)) {
+         Clause& c = _ca[cr];
+         removeWatch(_watches[index(~c[0])], cr);
+         removeWatch(_watches[index(~c[1])], cr);
+         _ca.free(cr);
+      }
+      else _learnts[j++] = cr;
+   }
+   _learnts.shrink(i - j);
+   checkGarbage();
+}
+
+void
+AigSolver::cleanWatches()
+{
+   for (int i = 0; i < _watches.size(); i++) {
+      vec<Watcher>& ws = _watches[i];
+      int j = 0;
+      for (int k = 0; k < ws.size(); k++)
+         if (!_ca[ws[k].cref].deleted()) ws[j++] = ws[k];
+      ws.shrink(ws.size() - j);
+   }
+}
+
+void
+AigSolver::garbageCollect()
+{
+   ClauseAllocator to(_ca.size() - _ca.wasted());
+   for (int i = 0; i < _watches.size(); i++) {
+      vec<Watcher>& ws = _watches[i];
+      for (int k = 0; k < ws.size(); k++) ws[k].cref = _ca.reloc(ws[k].cref, to);
+   }
+   for (int i = 0; i < _trail.size(); i++) {
+      uint& r = _reason[var(_trail[i])];
+      if (r != NoReason && !isGateReason(r))
+         r = _ca[r >> 1].deleted()? NoReason: clauseReason(_ca.reloc(r >> 1, to));
+   }
+   for (int i = 0; i < _learnts.size(); i++) _learnts[i] = _ca.reloc(_learnts[i], to);
+   for (int i = 0; i < _clauses.size(); i++) _clauses[i] = _ca.reloc(_clauses[i], to);
+   to.moveTo(_ca);
+}
+
+void
+AigSolver::printStats() const
+{
+   cout << "Nodes " << _assigns.size() << ", clauses " << _clauses.size()
+        << ", learnts " << _learnts.size() << ", conflicts " << _conflicts
+        << ", decisions " << _decisions << ", propagations " << _propagations
+        << endl;
+}
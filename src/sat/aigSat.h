@@ -0,0 +1,209 @@
+/****************************************************************************
+  FileName     [ aigSat.h ]
+  PackageName  [ sat ]
+  Synopsis     [ Define circuit SAT solver working on the AIG itself ]
+  Author       [ Chien-You (Benny) Huang ]
+  Copyright    [ Copyleft(c) 2010-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef AIG_SAT_H
+#define AIG_SAT_H
+
+#include "SolverTypes.h"
+
+using namespace std;
+
+/********** AigSolver **********/
+// A conflict-driven SAT solver whose problem is an and-inverter graph.
+// AND gates are kept as nodes and propagated through their fanins and
+// fanouts instead of through Tseitin clauses.  Decisions only justify
+// the J-frontier (gates assigned 0 with no false fanin), so the search
+// stays inside the cones the query reaches and a model is found as soon
+// as the frontier is empty.  Learnt clauses are kept in a ClauseAllocator
+// as in Solver.
+//
+// The interface is that of SatSolver; "addAigCNF()" and "addXorCNF()"
+// define gates, and the other "add...CNF()" calls add clauses.
+class AigSolver
+{
+   public :
+      AigSolver();
+      ~AigSolver() { }
+
+      // Solver initialization and reset
+      void initialize() { reset(); newVar(); }    // (Var 0 reserved as in SatSolver)
+      void reset();
+
+      // Constructing proof model
+      // Return the Var ID of the new Var, a free input until defined
+      Var newVar();
+      // vf = (va ^ fa) & (vb ^ fb); vf must be a fresh Var newer than va, vb
+      void addAigCNF(Var vf, Var va, bool fa, Var vb, bool fb);
+      // vf = (va ^ fa) ^ (vb ^ fb); vf must be a fresh Var newer than va, vb
+      void addXorCNF(Var vf, Var va, bool fa, Var vb, bool fb);
+      // Miter guarded by activation variable vf: vf -> (va != (vb ^ fb));
+      // "assertProperty(vf, false)" retires it and frees its nodes
+      void addMiterCNF(Var vf, Var va, Var vb, bool fb);
+      // va == (vb ^ fb); must be implied by the circuit
+      void addEqCNF(Var va, Var vb, bool fb);
+
+      // Justify "v" with value "val" first, as SatSolver::setPolarity()
+      void setPolarity(Var v, bool val) {
+         Lit p = _ext[v]; _polarity[var(p)] = (char)(val == sign(p));
+      }
+      void seedPolarity(Var v, size_t sig, unsigned bit = 0) {
+         setPolarity(v, (sig >> bit) & 1);
+      }
+
+      // For incremental proof, use "assumeSolve()"
+      void assumeRelease() { _assump.clear(); }
+      void assumeProperty(Var prop, bool val) {
+         _assump.push(val? _ext[prop]: ~_ext[prop]);
+      }
+      bool assumpSolve() {
+         int64 c = _confBudget, p = _propBudget;
+         _confBudget = _propBudget = -1;
+         int r = assumpSolveLimited();
+         _confBudget = c; _propBudget = p;
+         return r == 1;
+      }
+      // Per-query limits of "assumpSolveLimited()"; negative means no limit
+      void setBudget(int64 conflicts, int64 propagations) {
+         _confBudget = conflicts; _propBudget = propagations;
+      }
+      // Return 1/0/-1 for SAT/UNSAT/undecided (budget exhausted)
+      int assumpSolveLimited();
+
+      // For one time proof, use "solve"
+      void assertProperty(Var prop, bool val);
+
+      // Functions about Reporting
+      // Return 1/0/-1; -1 means unknown value
+      int getValue(Var v) const {
+         Lit p = _ext[v];
+         if (var(p) >= _model.size()) return -1;
+         return (_model[var(p)] != sign(p));
+      }
+      void printStats() const;
+      unsigned getNumVars() const { return _ext.size(); }
+
+   private :
+      // Reasons: a gate (whose clauses imply the value) or a clause
+      static const uint NoReason = UINT_MAX;
+      static uint gateReason  (Var g)  { return ((uint)g << 1) | 1; }
+      static uint clauseReason(CRef r) { return r << 1; }
+      static bool isGateReason(uint r) { return r & 1; }
+
+      lbool value(Var x) const { return toLbool(_assigns[x]); }
+      lbool value(Lit p) const {
+         return sign(p)? ~toLbool(_assigns[var(p)]): toLbool(_assigns[var(p)]);
+      }
+      bool isGate(Var x) const { return _fanin0[x] != lit_Undef; }
+      int  decisionLevel() const { return _trailLim.size(); }
+      bool withinBudget() const {
+         return (_confLimit < 0 || _conflicts < _confLimit)
+             && (_propLimit < 0 || _propagations < _propLimit);
+      }
+
+      Var  newNode(Lit a, Lit b);
+      void defineGate(Var n, Lit a, Lit b);
+      void undefineGate(Var n);
+      Var  newXor(Lit a, Lit b);
+      void removeFanout(Var x, Var g);
+      void addClause(vec<Lit>& ps);
+      void attach(CRef cr);
+      bool locked(CRef cr) const {
+         const Clause& c = _ca[cr];
+         return _reason[var(c[0])] == clauseReason(cr) && value(c[0]) == l_True;
+      }
+
+      void enqueue(Lit p, uint from);
+      void newDecisionLevel();
+      void cancelUntil(int level);
+      bool propagate();
+      bool propagateGate(Var g);
+      bool propagateClauses(Lit p);
+      void gateConflict(Var g);
+      void reasonLits(Var x, vec<Lit>& out);
+      void analyze(vec<Lit>& out_learnt, int& out_btlevel);
+      Lit  pickBranchLit();
+      void resetJFrontier();
+      int  search(int nof_conflicts);
+      void buildModel();
+
+      void varBump(Var x) {
+         if ((_activity[x] += _varInc) > 1e100) {
+            for (int i = 0; i < _activity.size(); i++) _activity[i] *= 1e-100;
+            _varInc *= 1e-100;
+         }
+      }
+      void claBump(Clause& c) {
+         if ((c.activity() += _claInc) > 1e20) {
+            for (int i = 0; i < _learnts.size(); i++) _ca[_learnts[i]].activity() *= 1e-20;
+            _claInc *= 1e-20;
+         }
+      }
+      void simplify();
+      void reduceDB();
+      void cleanWatches();
+      void checkGarbage() { if (_ca.wasted() > _ca.size() / 5) garbageCollect(); }
+      void garbageCollect();
+
+      // Problem: node x is an AND of _fanin0[x] and _fanin1[x], or a free
+      // input if they are lit_Undef; fanins are older than their gates
+      vec<Lit>          _ext;      // node literal of each interface Var
+      vec<Var>          _miter;    // XNOR node guarded by interface Var, if any
+      vec<Lit>          _fanin0;
+      vec<Lit>          _fanin1;
+      vec<vec<Var> >    _fanout;
+      ClauseAllocator   _ca;
+      vec<CRef>         _clauses;
+      vec<CRef>         _learnts;
+      vec<vec<Watcher> > _watches; // indexed by the literal that becomes true
+      bool              _ok;       // false once a conflict is found at level 0
+
+      // Assignment
+      vec<char>         _assigns;
+      vec<int>          _level;
+      vec<int>          _trailPos;
+      vec<uint>         _reason;
+      vec<Lit>          _trail;
+      vec<int>          _trailLim;
+      int               _qhead;
+      vec<Lit>          _assump;   // Assumption List for assumption solve
+
+      // J-frontier: every gate assigned 0 without a false fanin is on
+      // _jStack (with stale entries popped lazily); a gate popped because
+      // of a fanin assigned at a later level is pushed back by
+      // cancelUntil() through _jRestore of that level
+      vec<Var>          _jStack;
+      vec<vec<Var> >    _jRestore;
+
+      // Heuristics
+      vec<double>       _activity;
+      double            _varInc;
+      double            _claInc;
+      vec<char>         _polarity; // as Solver: 1 if the node prefers 0
+      double            _maxLearnts;
+      int64             _simpProps;
+      int               _simpAssigns;
+
+      // Scratch
+      vec<char>         _seen;
+      vec<Lit>          _conflict; // the clause falsified by the last conflict
+      vec<Lit>          _lits;
+      vec<Lit>          _learnt;
+      vec<Lit>          _toClear;
+      vec<char>         _model;    // node values of the last SAT answer
+
+      // Budgets and statistics
+      int64             _confBudget; // Conflicts per limited solve
+      int64             _propBudget; // Propagations per limited solve
+      int64             _confLimit;
+      int64             _propLimit;
+      int64             _conflicts;
+      int64             _decisions;
+      int64             _propagations;
+};
+
+#endif  // AIG_SAT_H
@@ -19,7 +19,7 @@ using namespace std;
 class SatSolver
 {
    public : 
-      SatSolver():_solver(0) { }
+      SatSolver():_solver(0), _confBudget(-1), _propBudget(-1) { }
       ~SatSolver() { if (_solver) delete _solver; }
 
       // Solver initialization and reset
@@ -65,12 +65,54 @@ class SatSolver
          _solver->addClause(lits); lits.clear();
       }
 
+      // Miter guarded by activation variable vf: vf -> (va != (vb ^ fb));
+      // retire it after the query with assertProperty(vf, false)
+      void addMiterCNF(Var vf, Var va, Var vb, bool fb) {
+         vec<Lit> lits;
+         Lit lf = Lit(vf);
+         Lit la = Lit(va);
+         Lit lb = fb? ~Lit(vb): Lit(vb);
+         lits.push(~lf); lits.push( la); lits.push( lb);
+         _solver->addClause(lits); lits.clear();
+         lits.push(~lf); lits.push(~la); lits.push(~lb);
+         _solver->addClause(lits); lits.clear();
+      }
+      // va == (vb ^ fb)
+      void addEqCNF(Var va, Var vb, bool fb) {
+         vec<Lit> lits;
+         Lit la = Lit(va);
+         Lit lb = fb? ~Lit(vb): Lit(vb);
+         lits.push(~la); lits.push( lb);
+         _solver->addClause(lits); lits.clear();
+         lits.push( la); lits.push(~lb);
+         _solver->addClause(lits); lits.clear();
+      }
+
+      // Branch on value "val" first when "v" is decided; e.g. seed with
+      // the simulation value so models follow a simulated pattern
+      void setPolarity(Var v, bool val) { _solver->setPolarity(v, !val); }
+      // Seed "v" with bit "bit" of the simulation signature "sig"
+      void seedPolarity(Var v, size_t sig, unsigned bit = 0) {
+         setPolarity(v, (sig >> bit) & 1);
+      }
+
       // For incremental proof, use "assumeSolve()"
       void assumeRelease() { _assump.clear(); }
       void assumeProperty(Var prop, bool val) {
          _assump.push(val? Lit(prop): ~Lit(prop));
       }
       bool assumpSolve() { return _solver->solve(_assump); }
+      // Per-query limits of "assumpSolveLimited()"; negative means no limit
+      void setBudget(int64 conflicts, int64 propagations) {
+         _confBudget = conflicts; _propBudget = propagations;
+      }
+      // Return 1/0/-1 for SAT/UNSAT/undecided (budget exhausted)
+      int assumpSolveLimited() {
+         _solver->setConfBudget(_confBudget);
+         _solver->setPropBudget(_propBudget);
+         lbool r = _solver->solveLimited(_assump);
+         return (r==l_True? 1: (r==l_False? 0: -1));
+      }
 
       // For one time proof, use "solve"
       void assertProperty(Var prop, bool val) {
@@ -84,11 +126,14 @@ class SatSolver
          return (_solver->modelValue(v)==l_True?1:
                 (_solver->modelValue(v)==l_False?0:-1)); }
       void printStats() const { const_cast<Solver*>(_solver)->printStats(); }
+      unsigned getNumVars() const { return _curVar; }
 
    private : 
       Solver           *_solver;    // Pointer to a Minisat solver
       Var               _curVar;    // Variable currently
       vec<Lit>          _assump;    // Assumption List for assumption solve
+      int64             _confBudget; // Conflicts per limited solve
+      int64             _propBudget; // Propagations per limited solve
 };
 
 #endif  // SAT_H
@@ -1,7 +1,7 @@
 /****************************************************************************
   FileName     [ myHashMap.h ]
   PackageName  [ util ]
-  Synopsis     [ Define HashMap and Cache ADT ]
+  Synopsis     [ Define HashMap, Cache and StrashTable ADT ]
   Author       [ Chung-Yang (Ric) Huang ]
   Copyright    [ Copyleft(c) 2009-present LaDs(III), GIEE, NTU, Taiwan ]
 ****************************************************************************/
@@ -280,4 +280,106 @@ private:
 };
 
 
+//---------------------------
+// Define StrashTable classes
+//---------------------------
+// Unique table for structural hashing: maps the fanin literals (a, b) of
+// an AND node to the node's data.  The pair is normalized, so (a, b) and
+// (b, a) are the same key, and it is mixed into a full 64-bit hash.
+// Slots live in one open-addressing array of power-of-two size kept at
+// most half full, probed linearly; "remove()" shifts the following slots
+// back instead of leaving tombstones.  Literal ~0u is reserved.
+class StrashTable
+{
+public:
+   StrashTable(size_t n = 0) : _mask(0), _size(0) { init(n); }
+
+   // Drop all entries and make room for "n" without rehashing
+   void init(size_t n) {
+      size_t cap = 16;
+      while (cap < 2*n) cap <<= 1;
+      _slots.assign(cap, Slot());
+      _mask = cap - 1; _size = 0;
+   }
+   void clear() { init(0); }
+   size_t size() const { return _size; }
+
+   // if (a, b) is in the table, set d to its data and return true;
+   // else return false
+   bool query(unsigned a, unsigned b, unsigned& d) const {
+      if (a > b) swap(a, b);
+      for (size_t i = bucketNum(a, b); !_slots[i].empty(); i = (i + 1) & _mask)
+         if (_slots[i].a == a && _slots[i].b == b) { d = _slots[i].d; return true; }
+      return false;
+   }
+   // if (a, b) is in the table, set d to its data and return true;
+   // else insert (a, b) with d and return false
+   bool queryOrInsert(unsigned a, unsigned b, unsigned& d) {
+      if (2*(_size + 1) > _slots.size()) rehash(2*_slots.size());
+      if (a > b) swap(a, b);
+      size_t i = bucketNum(a, b);
+      for (; !_slots[i].empty(); i = (i + 1) & _mask)
+         if (_slots[i].a == a && _slots[i].b == b) { d = _slots[i].d; return true; }
+      _slots[i].a = a; _slots[i].b = b; _slots[i].d = d;
+      ++_size;
+      return false;
+   }
+   // return true if inserted d successfully (i.e. (a, b) is not in the
+   // table); return false otherwise ==> will not insert
+   bool insert(unsigned a, unsigned b, unsigned d) {
+      unsigned old = d;
+      return !queryOrInsert(a, b, old);
+   }
+   // return true if (a, b) is removed; return false if it is not there
+   bool remove(unsigned a, unsigned b) {
+      if (a > b) swap(a, b);
+      size_t i = bucketNum(a, b);
+      for (; !_slots[i].empty(); i = (i + 1) & _mask)
+         if (_slots[i].a == a && _slots[i].b == b) break;
+      if (_slots[i].empty()) return false;
+      // Pull back every later slot of the run whose home is not between
+      // the hole and itself, so no probe sequence is cut short
+      for (size_t j = (i + 1) & _mask; !_slots[j].empty(); j = (j + 1) & _mask) {
+         size_t h = bucketNum(_slots[j].a, _slots[j].b);
+         if (((j - h) & _mask) >= ((j - i) & _mask)) { _slots[i] = _slots[j]; i = j; }
+      }
+      _slots[i] = Slot();
+      --_size;
+      return true;
+   }
+
+private:
+   struct Slot {
+      Slot() : a(~0u), b(~0u), d(0) {}
+      bool empty() const { return a == ~0u; }
+      unsigned a, b, d;
+   };
+
+   vector<Slot>   _slots;
+   size_t         _mask;
+   size_t         _size;
+
+   // 64-bit finalizer of MurmurHash3
+   size_t bucketNum(unsigned a, unsigned b) const {
+      size_t k = (size_t(a) << 32) | b;
+      k ^= k >> 33; k *= 0xff51afd7ed558ccdULL;
+      k ^= k >> 33; k *= 0xc4ceb9fe1a85ec53ULL;
+      k ^= k >> 33;
+      return k & _mask;
+   }
+   void rehash(size_t cap) {
+      vector<Slot> old;
+      old.swap(_slots);
+      _slots.assign(cap, Slot());
+      _mask = cap - 1;
+      for (size_t i = 0; i < old.size(); ++i) {
+         if (old[i].empty()) continue;
+         size_t j = bucketNum(old[i].a, old[i].b);
+         while (!_slots[j].empty()) j = (j + 1) & _mask;
+         _slots[j] = old[i];
+      }
+   }
+};
+
+
 #endif // MY_HASH_H
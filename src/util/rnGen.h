@@ -26,5 +26,55 @@ class RandomNumGen
       }
 };
 
+// xoshiro256** run as LANES independent streams seeded by splitmix64, so
+// that fill() produces LANES words per step with no carried dependency
+// between them; meant for bulk random simulation patterns
+class PatternGen
+{
+   public:
+      PatternGen(size_t seed = 0) { setSeed(seed); }
+      void setSeed(size_t seed) {
+         for (unsigned i = 0; i < 4; ++i)
+            for (unsigned l = 0; l < LANES; ++l) {
+               seed += 0x9e3779b97f4a7c15ULL;
+               size_t z = seed;
+               z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+               z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+               _s[i][l] = z ^ (z >> 31);
+            }
+      }
+      // Fill words[0..n-1] with random bits
+      void fill(size_t* words, size_t n) {
+         size_t i = 0;
+         for (; i + LANES <= n; i += LANES)
+            step(words + i);
+         if (i < n) {
+            size_t tmp[LANES];
+            step(tmp);
+            for (size_t l = 0; i < n; ++i, ++l)
+               words[i] = tmp[l];
+         }
+      }
+
+   private:
+      enum { LANES = 4 };
+      size_t _s[4][LANES];
+
+      static size_t rotl(size_t x, int k) { return (x << k) | (x >> (64 - k)); }
+      void step(size_t* out) {
+         for (unsigned l = 0; l < LANES; ++l)
+            out[l] = rotl(_s[1][l] * 5, 7) * 9;
+         for (unsigned l = 0; l < LANES; ++l) {
+            size_t t = _s[1][l] << 17;
+            _s[2][l] ^= _s[0][l];
+            _s[3][l] ^= _s[1][l];
+            _s[1][l] ^= _s[2][l];
+            _s[0][l] ^= _s[3][l];
+            _s[2][l] ^= t;
+            _s[3][l] = rotl(_s[3][l], 45);
+         }
+      }
+};
+
 #endif // RN_GEN_H
 
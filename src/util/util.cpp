@@ -24,6 +24,7 @@ using namespace std;
 //----------------------------------------------------------------------
 
 RandomNumGen  rnGen(0);  // use random seed = 0
+PatternGen    patGen(0); // reseeded by "CIRSIMulate -Seed"
 MyUsage       myUsage;
 
 
@@ -17,6 +17,7 @@ using namespace std;
 
 // Extern global variable defined in util.cpp
 extern RandomNumGen  rnGen;
+extern PatternGen    patGen;
 extern MyUsage       myUsage;
 
 // In myString.cpp